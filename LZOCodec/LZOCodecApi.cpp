@@ -0,0 +1,179 @@
+/* LZOCodec\LZOCodecApi.cpp -- C interface of the LZOStream block codec
+
+   This file is part of the LZOStream application for compressing/ decompressing files or streams.
+
+   Copyright (C) 2024 G DATA CyberDefense AG
+   All Rights Reserved.
+
+   The LZOStream application is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZOStream application is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZOStream application; see the file License.txt.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   G DATA CyberDefense AG
+   <source@gdata.de>
+   https://www.gdata.de/
+*/
+
+#include "../LZOStream/stdafx.h"
+#include "../LZOStream/LZOCodec.h"
+#include "LZOCodecApi.h"
+
+namespace
+{
+bool Initialized()
+{
+    static const auto initialized{lzo_init() == LZO_E_OK};
+
+    return initialized;
+}
+
+int Result(const std::errc error)
+{
+    switch (error)
+    {
+        case std::errc{}:
+            return LZOCODEC_OK;
+        case std::errc::no_buffer_space:
+            return LZOCODEC_ERROR_BUFFER;
+        case std::errc::invalid_argument:
+            return LZOCODEC_ERROR_ARGUMENT;
+        default:
+            return LZOCODEC_ERROR_DATA;
+    }
+}
+
+// Calls function with the verified LZOHeader64 or LZOHeader of the block at source (sourceSize covers its data)
+template <typename Function>
+int WithBlock(const void* source, const size_t sourceSize, Function function)
+{
+    if (!source)
+    {
+        return LZOCODEC_ERROR_ARGUMENT;
+    }
+    if (!Initialized())
+    {
+        return LZOCODEC_ERROR_INIT;
+    }
+    if (sourceSize >= LZOHeader64::Size() && LZOHeader64::Identifies(*(const uint32_t*)source))
+    {
+        const auto header{LZOHeader64::Header(source, sourceSize, true)};
+
+        return (header && header->SourceSize <= sourceSize - LZOHeader64::Size()) ? Result(function(header))
+                                                                                  : LZOCODEC_ERROR_DATA;
+    }
+
+    const auto header{LZOHeader::Header(source, sourceSize, true)};
+
+    return (header && LZOHeader::Identifies(header->HeaderId) && header->SourceSize <= sourceSize - LZOHeader::Size())
+               ? Result(function(header))
+               : LZOCODEC_ERROR_DATA;
+}
+}
+
+uint32_t LZOCodecFormat(const char* name)
+{
+    for (const auto& formatInfo : LZOFormat::FormatInfos())
+    {
+        if (name && formatInfo.second.FunctionCompress && !_stricmp(name, formatInfo.second.Name))
+        {
+            return (uint32_t)formatInfo.first;
+        }
+    }
+
+    return 0;
+}
+
+size_t LZOCodecWorkSize(const uint32_t format)
+{
+    const auto info{LZOFormat::FormatInfo((LZOFormat::Id)format)};
+
+    return (format && !info) ? 0 : LZOCodec::WorkSize(info);
+}
+
+size_t LZOCodecBound(const size_t size)
+{
+    return LZOCodec::BlockSize(size);
+}
+
+int LZOCodecCompress(const uint32_t format, const void* source, const size_t sourceSize, void* destination,
+    size_t* destinationSize, void* work)
+{
+    const auto info{LZOFormat::FormatInfo((LZOFormat::Id)format)};
+
+    if (!info || !info->FunctionCompress || (!source && sourceSize) || !destination || !destinationSize ||
+        (!work && info->MemoryCompress) || sourceSize > MAXDWORD)
+    {
+        return LZOCODEC_ERROR_ARGUMENT;
+    }
+    if (!Initialized())
+    {
+        return LZOCODEC_ERROR_INIT;
+    }
+    if (*destinationSize < LZOCodec::BlockSize(sourceSize))
+    {
+        return LZOCODEC_ERROR_BUFFER;
+    }
+
+    *destinationSize = LZOCodec::Compress(
+        (LZOFormat::Id)format, (const byte*)source, sourceSize, (byte*)destination, *destinationSize, work);
+
+    return (*destinationSize) ? LZOCODEC_OK : LZOCODEC_ERROR_ARGUMENT;
+}
+
+int LZOCodecSize(const void* source, const size_t sourceSize, uint64_t* size)
+{
+    return WithBlock(source, sourceSize, [&](const auto* header) {
+        if (!size)
+        {
+            return std::errc::invalid_argument;
+        }
+
+        *size = header->DestinationSize;
+
+        return std::errc{};
+    });
+}
+
+int LZOCodecVerify(const void* source, const size_t sourceSize)
+{
+    return WithBlock(source, sourceSize, [&](const auto* header) {
+        return LZOCodec::Verify(header);
+    });
+}
+
+int LZOCodecDecompress(
+    const void* source, const size_t sourceSize, void* destination, size_t* destinationSize, void* work)
+{
+    return WithBlock(source, sourceSize, [&](const auto* header) {
+        const auto  info{LZOFormat::FormatInfo(header->FormatId)};
+        const byte* data{};
+        size_t      size{};
+
+        if (!destination || !destinationSize || (info && info->MemoryDecompress && !work))
+        {
+            return std::errc::invalid_argument;
+        }
+
+        // Blocks of the caller are untrusted (their hash is no authentication), so they are always decompressed safe
+        const auto error{LZOCodec::Decompress(
+            header, (byte*)destination, *destinationSize, work, data, size, {}, LZOFormat::Decoder::Safe)};
+
+        if (error == std::errc{})
+        {
+            *destinationSize = size;
+        }
+
+        return error;
+    });
+}
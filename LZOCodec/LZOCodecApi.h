@@ -0,0 +1,80 @@
+/* LZOCodec\LZOCodecApi.h -- C interface of the LZOStream block codec
+
+   This file is part of the LZOStream application for compressing/ decompressing files or streams.
+
+   Copyright (C) 2024 G DATA CyberDefense AG
+   All Rights Reserved.
+
+   The LZOStream application is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZOStream application is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZOStream application; see the file License.txt.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   G DATA CyberDefense AG
+   <source@gdata.de>
+   https://www.gdata.de/
+*/
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/* Link LZOCodec.dll with its import library LZOCodec.lib, or the static LZOCodecStatic.lib (define LZOCODEC_STATIC) */
+#if defined(LZOCODEC_EXPORTS)
+#    define LZOCODEC_API __declspec(dllexport)
+#elif defined(LZOCODEC_STATIC)
+#    define LZOCODEC_API
+#else
+#    define LZOCODEC_API __declspec(dllimport)
+#endif
+
+#define LZOCODEC_OK             0
+#define LZOCODEC_ERROR_ARGUMENT (-1) /* Invalid argument or format */
+#define LZOCODEC_ERROR_BUFFER   (-2) /* Destination too small */
+#define LZOCODEC_ERROR_DATA     (-3) /* Invalid header, hash or data */
+#define LZOCODEC_ERROR_INIT     (-4) /* lzo_init failed */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Format id of a method name (e.g. "Lzo1x_1"), 0 if unknown */
+    LZOCODEC_API uint32_t LZOCodecFormat(const char* name);
+
+    /* Work memory for LZOCodecCompress/ LZOCodecDecompress with format (0: enough for all formats) */
+    LZOCODEC_API size_t LZOCodecWorkSize(uint32_t format);
+
+    /* Maximum size of a block (header and compressed data) for size bytes */
+    LZOCODEC_API size_t LZOCodecBound(size_t size);
+
+    /* Compresses source into a block (an lzostream file of one header) at destination,
+       *destinationSize is the size of destination (LZOCodecBound) and receives the size of the block */
+    LZOCODEC_API int LZOCodecCompress(uint32_t format, const void* source, size_t sourceSize, void* destination,
+        size_t* destinationSize, void* work);
+
+    /* Decompressed size of the block at source */
+    LZOCODEC_API int LZOCodecSize(const void* source, size_t sourceSize, uint64_t* size);
+
+    /* Verifies the header and the hash of the compressed data of the block at source */
+    LZOCODEC_API int LZOCodecVerify(const void* source, size_t sourceSize);
+
+    /* Verifies and decompresses the block at source into destination with the safe (bounds checked) decompressor,
+       blocks of formats without one (Lzo1, Lzo1a) are rejected,
+       *destinationSize is the size of destination and receives the decompressed size */
+    LZOCODEC_API int LZOCodecDecompress(
+        const void* source, size_t sourceSize, void* destination, size_t* destinationSize, void* work);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,260 @@
+/* LZOStream\LZOArena.h -- reusable page aligned buffers
+
+   This file is part of the LZOStream application for compressing/ decompressing files or streams.
+
+   Copyright (C) 2024 G DATA CyberDefense AG
+   All Rights Reserved.
+
+   The LZOStream application is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZOStream application is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZOStream application; see the file License.txt.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   G DATA CyberDefense AG
+   <source@gdata.de>
+   https://www.gdata.de/
+*/
+
+#pragma once
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+// Pool of page aligned buffers that are not initialized (VirtualAlloc, optionally large pages).
+// Released buffers are kept and handed out again, so work memory and block buffers are allocated once per process.
+// At most MaximumPooled bytes are kept, the largest released buffers beyond that are returned to the system.
+class LZOArena
+{
+public:
+    // Smaller buffers are not pooled
+    static constexpr size_t MinimumSize{64 * 1024};
+
+    // Bytes of released buffers kept for reuse
+    static constexpr size_t MaximumPooled{256 * 1024 * 1024};
+
+    LZOArena()
+    {
+        SYSTEM_INFO info{};
+
+        GetSystemInfo(&info);
+
+        _pageSize = std::max<size_t>(info.dwPageSize, 4096);
+    }
+    ~LZOArena()
+    {
+        for (const auto& buffer : _free)
+        {
+            VirtualFree(buffer.second, 0, MEM_RELEASE);
+        }
+        for (const auto& buffer : _used)
+        {
+            VirtualFree(buffer.first, 0, MEM_RELEASE);
+        }
+    }
+    LZOArena(const LZOArena&)            = delete;
+    LZOArena& operator=(const LZOArena&) = delete;
+
+    static LZOArena& Instance()
+    {
+        static LZOArena arena;
+
+        return arena;
+    }
+
+    // Uses large pages for buffers of at least the large page size, needs the privilege to lock pages in memory
+    bool LargePages()
+    {
+        HANDLE           token{};
+        TOKEN_PRIVILEGES privileges{1};
+
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+        if (!GetLargePageMinimum() || !OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES, &token))
+        {
+            return false;
+        }
+
+        const auto enabled{LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+                           AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+                           GetLastError() == ERROR_SUCCESS};
+
+        CloseHandle(token);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _largePageSize = (enabled) ? GetLargePageMinimum() : 0;
+
+        return enabled;
+    }
+
+    void* Allocate(const size_t size)
+    {
+        if (size < MinimumSize)
+        {
+            return ::operator new(size);
+        }
+
+        auto capacity{Round(size, _pageSize)};
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            // The smallest released buffer that fits (but not more than twice the size)
+            const auto found{_free.lower_bound(capacity)};
+
+            if (found != _free.end() && found->first / 2 <= capacity)
+            {
+                const auto data{found->second};
+
+                _used.emplace(data, found->first);
+                _reused += found->first;
+                _pooled -= found->first;
+                _free.erase(found);
+
+                return data;
+            }
+        }
+
+        void* data{};
+
+        if (_largePageSize && capacity >= _largePageSize)
+        {
+            capacity = Round(capacity, _largePageSize);
+            data     = VirtualAlloc(nullptr, capacity, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+        }
+        if (!data)
+        {
+            capacity = Round(size, _pageSize);
+            data     = VirtualAlloc(nullptr, capacity, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        }
+        if (!data)
+        {
+            throw std::bad_alloc();
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _used.emplace(data, capacity);
+        _allocated += capacity;
+
+        return data;
+    }
+
+    void Release(void* data, const size_t size)
+    {
+        if (size < MinimumSize)
+        {
+            ::operator delete(data);
+
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        const auto found{_used.find(data)};
+
+        if (found != _used.end())
+        {
+            _free.emplace(found->second, found->first);
+            _pooled += found->second;
+            _used.erase(found);
+        }
+        while (_pooled > MaximumPooled)
+        {
+            const auto largest{std::prev(_free.end())};
+
+            VirtualFree(largest->second, 0, MEM_RELEASE);
+
+            _pooled -= largest->first;
+            _free.erase(largest);
+        }
+    }
+
+    // Bytes of all buffers allocated from the system
+    uint64_t Allocated() const
+    {
+        return _allocated;
+    }
+
+    // Bytes of all buffers handed out again
+    uint64_t Reused() const
+    {
+        return _reused;
+    }
+
+private:
+    static size_t Round(const size_t size, const size_t alignment)
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    std::mutex                   _mutex;
+    std::multimap<size_t, void*> _free;
+    std::map<void*, size_t>      _used;
+    size_t                       _pageSize{};
+    size_t                       _largePageSize{};
+    size_t                       _pooled{};
+    std::atomic<uint64_t>        _allocated{};
+    std::atomic<uint64_t>        _reused{};
+};
+
+// Allocator of the LZOArena, elements are default initialized (a resized buffer is not zeroed)
+template <typename T>
+class LZOAllocator
+{
+public:
+    using value_type = T;
+
+    LZOAllocator() = default;
+    template <typename U>
+    LZOAllocator(const LZOAllocator<U>&)
+    {
+    }
+
+    T* allocate(const size_t count)
+    {
+        return (T*)LZOArena::Instance().Allocate(count * sizeof(T));
+    }
+
+    void deallocate(T* data, const size_t count)
+    {
+        LZOArena::Instance().Release(data, count * sizeof(T));
+    }
+
+    template <typename U>
+    void construct(U* data) noexcept(std::is_nothrow_default_constructible_v<U>)
+    {
+        ::new ((void*)data) U;
+    }
+
+    template <typename U, typename... Arguments>
+    void construct(U* data, Arguments&&... arguments)
+    {
+        ::new ((void*)data) U(std::forward<Arguments>(arguments)...);
+    }
+
+    template <typename U>
+    bool operator==(const LZOAllocator<U>&) const
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const LZOAllocator<U>&) const
+    {
+        return false;
+    }
+};
@@ -0,0 +1,415 @@
+/* LZOStream\LZOCodec.h -- block compression/ decompression into caller buffers
+
+   This file is part of the LZOStream application for compressing/ decompressing files or streams.
+
+   Copyright (C) 2024 G DATA CyberDefense AG
+   All Rights Reserved.
+
+   The LZOStream application is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZOStream application is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZOStream application; see the file License.txt.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   G DATA CyberDefense AG
+   <source@gdata.de>
+   https://www.gdata.de/
+*/
+
+#pragma once
+#include "LZOFormat.h"
+#include "LZOHeader.h"
+#include "LZOHash.h"
+#include "LZODictionary.h"
+#include <system_error>
+#include <cmath>
+#include <intrin.h>
+
+// Compresses/ decompresses one block (header and data) with caller provided buffers, nothing is allocated
+class LZOCodec
+{
+public:
+    // Blocks of MinimumSampledSize...MaximumSampledSize (the largest block of a block stream) are sampled to detect
+    // incompressible data, larger data (a whole input behind a single header) is always compressed and compared
+    static constexpr size_t MinimumSampledSize{128 * 1024};
+    static constexpr size_t MaximumSampledSize{64 * 1024 * 1024};
+
+    // Maximum size of compressed data
+    static size_t CompressedSize(const size_t size)
+    {
+        return size + size / 16 + 64 + 3;
+    }
+
+    // Maximum size of a block (header included, a block with dictionary has a header with 64 bit sizes)
+    static size_t BlockSize(const size_t size)
+    {
+        return LZOHeader64::Size(CompressedSize(size));
+    }
+
+    // Work memory for compression and decompression with info (nullptr: largest of all formats)
+    static size_t WorkSize(const LZOFormat::Info* info = {})
+    {
+        if (info)
+        {
+            return std::max<size_t>(info->MemoryCompress, info->MemoryDecompress);
+        }
+
+        size_t size{};
+
+        for (const auto& formatInfo : LZOFormat::FormatInfos())
+        {
+            size = std::max<size_t>(size, WorkSize(&formatInfo.second));
+        }
+
+        return size;
+    }
+
+    // Estimates that data is not compressible: the byte entropy of samples is close to 8 bits (random, encrypted or
+    // compressed data), only blocks of MinimumSampledSize...MaximumSampledSize are checked
+    static bool Incompressible(const byte* data, const size_t size)
+    {
+        constexpr size_t samples{4};
+        constexpr size_t sampleSize{4096};
+        uint32_t         counts[256]{};
+        double           entropy{};
+
+        if (size < MinimumSampledSize || size > MaximumSampledSize)
+        {
+            return false;
+        }
+
+        for (size_t sample{}; sample < samples; ++sample)
+        {
+            const auto offset{(size - sampleSize) / (samples - 1) * sample};
+
+            for (size_t index{}; index < sampleSize; ++index)
+            {
+                ++counts[data[offset + index]];
+            }
+        }
+        for (const auto count : counts)
+        {
+            if (count)
+            {
+                const auto probability{count / double(samples * sampleSize)};
+
+                entropy -= probability * std::log2(probability);
+            }
+        }
+
+        return entropy > 7.9;
+    }
+
+    // Whether size bytes (at least one) are all the same byte, 64 bytes per step (SSE2)
+    static bool Filled(const byte* data, size_t size)
+    {
+        const auto fill{*data};
+        const auto fills{_mm_set1_epi8((char)fill)};
+
+        for (; size >= 64; data += 64, size -= 64)
+        {
+            const auto bits{_mm_and_si128(
+                _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)data), fills),
+                    _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), fills)),
+                _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), fills),
+                    _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), fills)))};
+
+            if (_mm_movemask_epi8(bits) != 0xffff)
+            {
+                return false;
+            }
+        }
+        for (; size; ++data, --size)
+        {
+            if (*data != fill)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Compresses data into block (BlockSize(size) bytes) behind a header, the block is stored (format None) if the data
+    // is not compressible (with limitLess only if compression fails), returns the block size (0 if block is too small).
+    // Data of a single repeated byte is not compressed but written as a fill block (format Fill, that one byte).
+    // Without limitLess incompressible data is detected by the entropy of samples before the compression of the block
+    // (see Incompressible). The hashes are built with checksum.
+    // With a dictionary the block has a header with 64 bit sizes that records the dictionary Id. A level 1...9 selects
+    // the match search of formats with FunctionCompressLevel (0: the default of the format). With optimize (a buffer of
+    // size bytes the data is decompressed into) the compressed data of formats with FunctionOptimize is rewritten for
+    // faster decompression, blocks with a dictionary are not optimized. With header64 (a block of a stream) the block
+    // has a header with 64 bit sizes as well.
+    static size_t Compress(const LZOFormat::Id format, const byte* data, const size_t size, byte* block,
+        const size_t blockSize, void* work, const bool limitLess = false,
+        const LZOHash::Checksum checksum = LZOHash::Checksum::Adler32, const LZODictionary& dictionary = {},
+        const int level = 0, byte* optimize = nullptr, const bool header64 = false)
+    {
+        if (dictionary.Size || header64)
+        {
+            return Compress((LZOHeader64*)block, format, data, size, blockSize, work, limitLess, checksum, dictionary,
+                level, optimize);
+        }
+
+        return Compress((LZOHeader*)block, format, data, size, blockSize, work, limitLess, checksum, dictionary, level,
+            optimize);
+    }
+
+    // Verifies the sizes and the hash of the data behind header (with the checksum of the header version)
+    template <typename Header>
+    static std::errc Verify(const Header* header)
+    {
+        if (header->SourceSize > SIZE_MAX || header->DestinationSize > SIZE_MAX)
+        {
+            return std::errc::not_enough_memory;
+        }
+        if (header->SourceHash != 0 &&
+            header->SourceHash != LZOHash::Hash(header->Checksum(), header->Data(), (size_t)header->SourceSize))
+        {
+            return std::errc::illegal_byte_sequence;
+        }
+
+        return {};
+    }
+
+    // Verifies and decompresses the data behind header into target (targetSize bytes, at least DestinationSize),
+    // without target stored data is passed through without copying. A block with a dictionary Id needs that dictionary.
+    // The Fast and Asm decoders are used only for data verified by its SourceHash (Asm with LZOFormat::AsmSlack bytes
+    // of targetSize behind DestinationSize), otherwise the data is decompressed safe. Formats without a safe
+    // decompressor are not supported for the Safe decoder and for data without SourceHash.
+    template <typename Header>
+    static std::errc Decompress(const Header* header, byte* target, const size_t targetSize, void* work,
+        const byte*& data, size_t& size, const LZODictionary& dictionary = {},
+        const LZOFormat::Decoder decoder = LZOFormat::Decoder::Fast)
+    {
+        const auto error{Verify(header)};
+
+        if (error != std::errc{})
+        {
+            return error;
+        }
+        if (target && targetSize < header->DestinationSize)
+        {
+            return std::errc::no_buffer_space;
+        }
+        if (header->FormatId == LZOFormat::Id::None)
+        {
+            if (header->SourceSize != header->DestinationSize || header->SourceHash != header->DestinationHash ||
+                (target && memcpy_s(target, targetSize, header->Data(), (size_t)header->SourceSize)))
+            {
+                return std::errc::illegal_byte_sequence;
+            }
+
+            data = (target) ? target : header->Data();
+            size = (size_t)header->SourceSize;
+
+            return {};
+        }
+        if (header->FormatId == LZOFormat::Id::Fill)
+        {
+            if (header->SourceSize != 1)
+            {
+                return std::errc::illegal_byte_sequence;
+            }
+            if (!target)
+            {
+                return std::errc::no_buffer_space;
+            }
+
+            memset(target, *header->Data(), (size_t)header->DestinationSize);
+
+            if (header->DestinationHash != 0 &&
+                header->DestinationHash !=
+                    LZOHash::Hash(header->Checksum(), target, (size_t)header->DestinationSize))
+            {
+                return std::errc::illegal_byte_sequence;
+            }
+
+            data = target;
+            size = (size_t)header->DestinationSize;
+
+            return {};
+        }
+
+        const auto info{LZOFormat::FormatInfo(header->FormatId)};
+        uint32_t   dictionaryId{};
+
+        if constexpr (std::is_same_v<Header, LZOHeader64>)
+        {
+            dictionaryId = header->DictionaryId;
+        }
+        if (!info || !info->FunctionDecompress || (dictionaryId && !info->FunctionDecompressDict))
+        {
+            return std::errc::not_supported;
+        }
+        if (dictionaryId && dictionaryId != dictionary.Id)
+        {
+            return std::errc::invalid_argument;
+        }
+        if (!target)
+        {
+            return std::errc::no_buffer_space;
+        }
+
+        const auto decompress{(dictionaryId) ? nullptr
+                                             : info->Decompressor(decoder, header->SourceHash != 0,
+                                                   targetSize - (size_t)header->DestinationSize)};
+
+        if (!dictionaryId && !decompress)
+        {
+            return std::errc::not_supported;
+        }
+
+        lzo_uint decompressedSize{(lzo_uint)header->DestinationSize};
+        int      result{};
+
+        try
+        {
+            if (dictionaryId)
+            {
+                result = info->FunctionDecompressDict(header->Data(), (lzo_uint)header->SourceSize, target,
+                    &decompressedSize, work, dictionary.Data, dictionary.Size);
+            }
+            else
+            {
+                result = decompress(header->Data(), (lzo_uint)header->SourceSize, target, &decompressedSize, work);
+            }
+        }
+        catch (std::exception&)
+        {
+            result = -1;
+        }
+
+        if (result != LZO_E_OK)
+        {
+            return std::errc::bad_address;
+        }
+        if (decompressedSize != header->DestinationSize ||
+            (header->DestinationHash != 0 &&
+                header->DestinationHash != LZOHash::Hash(header->Checksum(), target, decompressedSize)))
+        {
+            return std::errc::illegal_byte_sequence;
+        }
+
+        data = target;
+        size = decompressedSize;
+
+        return {};
+    }
+
+private:
+    template <typename Header>
+    static size_t Compress(Header* header, const LZOFormat::Id format, const byte* data, const size_t size,
+        const size_t blockSize, void* work, const bool limitLess, const LZOHash::Checksum checksum,
+        const LZODictionary& dictionary, const int level, byte* optimize)
+    {
+        const auto info{LZOFormat::FormatInfo(format)};
+        lzo_uint   compressedSize{CompressedSize(size)};
+
+        if (!info || !info->FunctionCompress || (dictionary.Size && !info->FunctionCompressDict) ||
+            (level && !info->FunctionCompressLevel) || level < 0 || level > 9 || size > MAXDWORD ||
+            blockSize < Header::Size(compressedSize))
+        {
+            return 0;
+        }
+
+        if (size && Filled(data, size))
+        {
+            const auto sourceHash{LZOHash::Hash(checksum, data, 1)};
+            const auto destinationHash{LZOHash::Hash(checksum, data, size)};
+
+            *header->Data() = *data;
+
+            if constexpr (std::is_same_v<Header, LZOHeader64>)
+            {
+                header->Initialize(LZOFormat::Id::Fill, 1, size, sourceHash, destinationHash, 0, checksum);
+            }
+            else
+            {
+                header->Initialize(LZOFormat::Id::Fill, 1, (uint32_t)size, sourceHash, destinationHash, checksum);
+            }
+
+            return Header::Size(1);
+        }
+
+        const auto compress{[&](const size_t sourceSize, lzo_uint* destinationSize) {
+            if (level)
+            {
+                return info->FunctionCompressLevel(data, sourceSize, header->Data(), destinationSize, work,
+                    dictionary.Data, dictionary.Size, nullptr, level);
+            }
+            if (dictionary.Size)
+            {
+                return info->FunctionCompressDict(
+                    data, sourceSize, header->Data(), destinationSize, work, dictionary.Data, dictionary.Size);
+            }
+
+            return info->FunctionCompress(data, sourceSize, header->Data(), destinationSize, work);
+        }};
+        int result{-1};
+
+        try
+        {
+            if (limitLess || !Incompressible(data, size))
+            {
+                result = compress(size, &compressedSize);
+            }
+            if (result == LZO_E_OK && (limitLess || compressedSize < size) && optimize && info->FunctionOptimize &&
+                !dictionary.Size)
+            {
+                lzo_uint optimizedSize{size};
+
+                result = info->FunctionOptimize(header->Data(), compressedSize, optimize, &optimizedSize, work);
+                result = (result == LZO_E_OK && optimizedSize == size) ? LZO_E_OK : -1;
+            }
+        }
+        catch (std::exception&)
+        {
+            result = -1;
+        }
+
+        if (result == LZO_E_OK && (limitLess || compressedSize < size))
+        {
+            const auto sourceHash{LZOHash::Hash(checksum, header->Data(), compressedSize)};
+            const auto destinationHash{LZOHash::Hash(checksum, data, size)};
+
+            if constexpr (std::is_same_v<Header, LZOHeader64>)
+            {
+                header->Initialize(
+                    format, compressedSize, size, sourceHash, destinationHash, dictionary.Id, checksum);
+            }
+            else
+            {
+                header->Initialize(format, compressedSize, (uint32_t)size, sourceHash, destinationHash, checksum);
+            }
+
+            return Header::Size(compressedSize);
+        }
+
+        const auto sourceDestinationHash{LZOHash::Hash(checksum, data, size)};
+
+        memcpy_s(header->Data(), blockSize - Header::Size(), data, size);
+
+        if constexpr (std::is_same_v<Header, LZOHeader64>)
+        {
+            header->Initialize(
+                LZOFormat::Id::None, size, size, sourceDestinationHash, sourceDestinationHash, 0, checksum);
+        }
+        else
+        {
+            header->Initialize(LZOFormat::Id::None, (uint32_t)size, (uint32_t)size, sourceDestinationHash,
+                sourceDestinationHash, checksum);
+        }
+
+        return Header::Size(size);
+    }
+};
@@ -28,9 +28,16 @@
 #pragma once
 #include "LZOFormat.h"
 #include "LZOHeader.h"
+#include "LZOCodec.h"
+#include "LZOFile.h"
+#include "LZOArena.h"
+#include "LZOPipeline.h"
+#include "LZODictionary.h"
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <chrono>
+#include <set>
 
 constexpr auto TitleVersion{_T("LZOStream v1.0")};
 
@@ -38,14 +45,97 @@ class LZOCommand
 {
 public:
     const uint32_t BufferSize{1024 * 1024};
-    using Bytes = std::vector<byte>;
+    const uint32_t MinimumBlockSize{256 * 1024};
+    const uint32_t MaximumBlockSize{64 * 1024 * 1024};
+    const uint32_t DefaultBlockSize{4 * 1024 * 1024};
+    const uint32_t SampleCount{4};
+    const uint32_t SampleSize{64 * 1024};
+    const uint32_t DefaultTargetSpeed{50};
+    const uint32_t MaximumDepth{64};
+    const uint32_t MaximumThreads{64};
+    using Bytes = std::vector<byte, LZOAllocator<byte>>;
+
+    struct Block
+    {
+        Bytes         Data;
+        size_t        Size{};
+        Bytes         Compressed;
+        size_t        CompressedSize{};
+        const byte*   Source{};
+        const byte*   Result{};
+        LZOFile::View View;
+    };
+
+    // Directory entry and name of an archive member
+    struct Member
+    {
+        LZOArchiveEntry Entry;
+        std::string     Name;
+    };
+
+    // Collects sizes and time of a command for -v|--verbose
+    class Statistics
+    {
+    public:
+        Statistics(const size_t threads)
+            : _threads(threads)
+        {
+        }
+
+        void Add(const uint64_t compressed, const uint64_t decompressed, const bool stored = false)
+        {
+            _compressed += compressed;
+            _decompressed += decompressed;
+            _blocks += 1;
+            _stored += (stored) ? 1 : 0;
+        }
+
+        // access: the I/O of --direct per file (empty without)
+        void Print(LPCTSTR action, const std::tstring& access = {}) const
+        {
+            const auto seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count()};
+            const auto megabytes{_decompressed / (1024.0 * 1024.0)};
+
+            std::tcerr << action << _T(" ") << _decompressed << _T(" bytes (") << _compressed
+                       << _T(" bytes compressed) in ") << std::fixed << std::setprecision(3) << seconds << _T(" s, ")
+                       << std::setprecision(2) << ((seconds > 0) ? megabytes / seconds : 0) << _T(" MB/s, ")
+                       << _threads << _T(" thread(s), ") << _stored << _T(" of ") << _blocks << _T(" block(s) stored")
+                       << std::endl;
+            std::tcerr << _T("Buffers ") << LZOArena::Instance().Allocated() << _T(" bytes allocated, ")
+                       << LZOArena::Instance().Reused() << _T(" bytes reused") << std::endl;
+            std::tcerr << _T("Cache ") << (int64_t)LZOFile::CacheSize() - (int64_t)_cache
+                       << _T(" bytes system file cache growth") << ((access.empty()) ? _T("") : _T(", ")) << access
+                       << std::endl;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point _start{std::chrono::steady_clock::now()};
+        size_t                                _threads{};
+        uint64_t                              _compressed{};
+        uint64_t                              _decompressed{};
+        uint64_t                              _blocks{};
+        uint64_t                              _stored{};
+        uint64_t                              _cache{LZOFile::CacheSize()};
+    };
 
     enum class Command
     {
         None,
         Compress,
         Decompress,
-        Info
+        Info,
+        Extract,
+        Bench,
+        Archive,
+        List,
+        Dictionary,
+        Test
+    };
+    enum class Export
+    {
+        Table,
+        Csv,
+        Json
     };
     enum class Option
     {
@@ -53,7 +143,20 @@ public:
         Input,
         Output,
         Format,
-        Block
+        Block,
+        Threads,
+        Offset,
+        Length,
+        Repeat,
+        Export,
+        TargetSpeed,
+        TargetRatio,
+        Checksum,
+        Member,
+        Dictionary,
+        Level,
+        Decoder,
+        Async
     };
 
     LZOCommand()
@@ -96,6 +199,52 @@ public:
             }
         }
 
+        if (_largePages && !LZOArena::Instance().LargePages() && _verbose)
+        {
+            std::tcerr << _T("Large pages not available") << std::endl;
+        }
+
+        if (!_dictionaryFile.empty() && _command != Command::Dictionary && !LoadDictionary())
+        {
+            return _error;
+        }
+        if (!_dictionary.empty() && (_command == Command::Compress || _command == Command::Archive))
+        {
+            const auto info{LZOFormat::FormatInfo((_format == LZOFormat::Id::None) ? LZOFormat::Id::Default : _format)};
+
+            if (_auto || !info || !info->FunctionCompressDict)
+            {
+                Message(_T("Dictionary needs format Lzo1x_999, Lzo1y_999 or Lzo1z_999"));
+
+                return Error(std::errc::invalid_argument);
+            }
+        }
+        if (_level && (_command == Command::Compress || _command == Command::Archive))
+        {
+            const auto info{LZOFormat::FormatInfo((_format == LZOFormat::Id::None) ? LZOFormat::Id::Default : _format)};
+
+            if (_auto || !info || !info->FunctionCompressLevel)
+            {
+                Message(_T("Level needs format Lzo1x_999, Lzo1y_999 or Lzo1z_999"));
+
+                return Error(std::errc::invalid_argument);
+            }
+        }
+        if (_optimize && (_command == Command::Compress || _command == Command::Archive))
+        {
+            const auto info{LZOFormat::FormatInfo((_format == LZOFormat::Id::None) ? LZOFormat::Id::Default : _format)};
+
+            if (_auto || !info || !info->FunctionOptimize || !_dictionary.empty())
+            {
+                Message(_T("Optimize needs format Lzo1x or Lzo1y without dictionary"));
+
+                return Error(std::errc::invalid_argument);
+            }
+        }
+        if (_batch && (_command == Command::Compress || _command == Command::Decompress))
+        {
+            return Batch();
+        }
         if (_command == Command::Compress)
         {
             return Compress();
@@ -108,52 +257,148 @@ public:
         {
             return Info();
         }
+        if (_command == Command::Extract)
+        {
+            return Extract();
+        }
+        if (_command == Command::Bench)
+        {
+            return Bench();
+        }
+        if (_command == Command::Archive)
+        {
+            return Archive();
+        }
+        if (_command == Command::List)
+        {
+            return List();
+        }
+        if (_command == Command::Dictionary)
+        {
+            return BuildDictionary();
+        }
+        if (_command == Command::Test)
+        {
+            return Test();
+        }
 
         return Help();
     }
 
     int Compress()
     {
-        const auto input{Input()};
+        if (_auto && _headerLess)
+        {
+            Message(_T("Format auto needs a header"));
 
-        if (input.empty())
+            return Error(std::errc::invalid_argument);
+        }
+        if (_stream && _headerLess)
         {
-            return _error;
+            Message(_T("Streaming needs a header"));
+
+            return Error(std::errc::invalid_argument);
+        }
+        if (_async && _headerLess)
+        {
+            Message(_T("Asynchronous I/O needs a header"));
+
+            return Error(std::errc::invalid_argument);
         }
+        if (_direct && _headerLess)
+        {
+            Message(_T("Direct I/O needs a header"));
 
+            return Error(std::errc::invalid_argument);
+        }
         if (_format == LZOFormat::Id::None)
         {
             _format = LZOFormat::Id::Default;
         }
 
-        try
+        auto info{LZOFormat::FormatInfo(_format)};
+
+        if (!info || !info->FunctionCompress)
         {
-            const auto info{LZOFormat::FormatInfo(_format)};
+            return Error(std::errc::not_supported);
+        }
+        // A single header has 32 bit sizes, inputs that may be larger (a pipe is read to its end) are written as blocks.
+        // The blocks of a dictionary have headers with 64 bit sizes, which are only written in a stream (with trailer).
+        if ((_block || _threads || _index || _stream || _async || _direct || _optimize || !_dictionary.empty() ||
+                InputSize() > MAXDWORD) &&
+            !_headerLess)
+        {
+            return CompressBlocks(info);
+        }
 
-            if (!info || !info->FunctionCompress)
-            {
-                return Error(std::errc::not_supported);
-            }
+        LZOFile       file;
+        LZOFile::View view;
+        uint64_t      mappedSize{};
+        Bytes         input;
+
+        if (_mapped && file.OpenRead(_input) && file.Size(mappedSize) && file.CreateMapping(false, mappedSize))
+        {
+            view = file.Map(0, (size_t)mappedSize);
+        }
+        if (!view.Data())
+        {
+            file.Close();
+            input = Input();
+        }
 
-            lzo_uint compressedSize{input.size() + input.size() / 16 + 64 + 3};
+        const auto data{(view.Data()) ? view.Data() : input.data()};
+        const auto size{(view.Data()) ? (size_t)mappedSize : input.size()};
+
+        if (!size)
+        {
+            return _error;
+        }
 
+        try
+        {
+            if (_auto)
+            {
+                info = SelectFormat(Sample(data, size));
+            }
             if (_headerLess)
             {
-                Bytes compressed(compressedSize);
-                Bytes work(info->MemoryCompress);
-                int   result{};
+                lzo_uint compressedSize{LZOCodec::CompressedSize(size)};
+                Bytes    compressed(compressedSize);
+                Bytes    work(info->MemoryCompress);
+                int      result{};
 
                 try
                 {
-                    result = info->FunctionCompress(
-                        input.data(), input.size(), compressed.data(), &compressedSize, work.data());
+                    if (_level)
+                    {
+                        result = info->FunctionCompressLevel(data, size, compressed.data(), &compressedSize,
+                            work.data(), _dictionary.data(), _dictionary.size(), nullptr, _level);
+                    }
+                    else if (_dictionary.empty())
+                    {
+                        result = info->FunctionCompress(data, size, compressed.data(), &compressedSize, work.data());
+                    }
+                    else
+                    {
+                        result = info->FunctionCompressDict(data, size, compressed.data(), &compressedSize,
+                            work.data(), _dictionary.data(), _dictionary.size());
+                    }
                 }
                 catch (std::exception&)
                 {
                     result = -1;
                 }
 
-                if (result == LZO_E_OK && (_limitLess || compressedSize < input.size()))
+                if (result == LZO_E_OK && _optimize)
+                {
+                    Bytes    optimized(size);
+                    lzo_uint optimizedSize{size};
+
+                    result = info->FunctionOptimize(
+                        compressed.data(), compressedSize, optimized.data(), &optimizedSize, work.data());
+                    result = (result == LZO_E_OK && optimizedSize == size) ? LZO_E_OK : -1;
+                }
+                if (result == LZO_E_OK && (_limitLess || compressedSize < size))
                 {
                     compressed.resize(compressedSize);
 
@@ -163,39 +408,16 @@ public:
                 return Error(std::errc::bad_address);
             }
 
-            Bytes compressed(LZOHeader::Size(compressedSize));
-            auto  header{LZOHeader::Header(compressed.data(), compressed.size())};
-            Bytes work(info->MemoryCompress);
-            int   result{};
-
-            try
-            {
-                result =
-                    info->FunctionCompress(input.data(), input.size(), header->Data(), &compressedSize, work.data());
-            }
-            catch (std::exception&)
-            {
-                result = -1;
-            }
+            Bytes      compressed;
+            Bytes      work;
+            const auto compressedSize{CompressBlock(_format, data, size, compressed, work)};
 
-            if (result == LZO_E_OK && (_limitLess || compressedSize < input.size()))
+            if (!compressedSize)
             {
-                const auto sourceHash{lzo_adler32(0, header->Data(), compressedSize)};
-                const auto destinationHash{lzo_adler32(0, input.data(), input.size())};
-
-                header->Initialize(_format, compressedSize, input.size(), sourceHash, destinationHash);
-                compressed.resize(LZOHeader::Size(compressedSize));
-
-                return Output(compressed);
+                return Error(std::errc::bad_address);
             }
 
-            lzo_uint   size{input.size()};
-            const auto sourceDestinationHash{lzo_adler32(0, input.data(), size)};
-
-            memcpy_s(header->Data(), compressedSize, input.data(), size);
-
-            header->Initialize(LZOFormat::Id::None, size, size, sourceDestinationHash, sourceDestinationHash);
-            compressed.resize(LZOHeader::Size(size));
+            compressed.resize(compressedSize);
 
             return Output(compressed);
         }
@@ -207,112 +429,343 @@ public:
         return Error({});
     }
 
-    int Decompress()
+    // Compresses blocks on _threads workers, blocks are written in input order (output independent of _threads),
+    // the stream ends with an optional index (_index) and a trailer
+    int CompressBlocks(const LZOFormat::Info* info)
     {
-        const auto input{Input()};
+        if (!_block)
+        {
+            _block = DefaultBlockSize;
+        }
+        if (_block < MinimumBlockSize || _block > MaximumBlockSize)
+        {
+            Message(_T("Invalid block size"));
 
-        if (input.empty())
+            return Error(std::errc::invalid_argument);
+        }
+
+        LZOFile input;
+        LZOFile output;
+
+        if (!OpenInput(input, _async, _direct) || !OpenOutput(output, false, _async, _direct))
         {
             return _error;
         }
 
         try
         {
-            if (_headerLess)
+            // -f auto samples a seekable input, otherwise the first block
+            auto select{_auto};
+
+            if (select && input.Seekable())
+            {
+                info   = SelectFormat(Sample(input));
+                select = false;
+            }
+
+            Statistics                 statistics(Threads());
+            LZOHeader64                trailer;
+            std::vector<LZOIndexEntry> index;
+            std::vector<Bytes>         works(Threads());
+            LZOPipeline<Block>         pipeline(
+                works.size(),
+                [&](Block& block, const size_t worker) {
+                    block.CompressedSize =
+                        CompressBlock(_format, block.Source, block.Size, block.Compressed, works[worker], true);
+
+                    return (block.CompressedSize) ? std::errc{} : std::errc::bad_address;
+                },
+                [&](Block& block) {
+                    if (!output.Write(block.Compressed.data(), block.CompressedSize))
+                    {
+                        Message(_T("Error writing output"));
+
+                        return std::errc::bad_address;
+                    }
+
+                    if (_index)
+                    {
+                        index.push_back({trailer.SourceSize, block.CompressedSize, block.Size});
+                    }
+                    WithHeader(block.Compressed.data(), [&](const auto* header) {
+                        statistics.Add(block.CompressedSize, block.Size, header->FormatId == LZOFormat::Id::None);
+                        trailer.Append(header);
+                    });
+                    block.View = {};
+
+                    return std::errc{};
+                },
+                _stream);
+            uint64_t   size{};
+            const auto mapped{_mapped && !_direct && input.Size(size) && input.CreateMapping(false, size)};
+            uint64_t   offset{};
+            size_t     read{};
+
+            do
             {
-                const auto info{LZOFormat::FormatInfo(_format)};
+                auto block{pipeline.Acquire()};
 
-                if (!info || !info->FunctionDecompress)
+                if (mapped)
                 {
-                    return Error(std::errc::not_supported);
+                    block.Size   = (size_t)std::min<uint64_t>(_block, size - offset);
+                    block.View   = input.Map(offset, block.Size);
+                    block.Source = block.View.Data();
+
+                    if (block.Size && !block.Source)
+                    {
+                        Message(_T("Error mapping input"));
+                        pipeline.Finish();
+
+                        return Error(std::errc::not_enough_memory);
+                    }
                 }
+                else
+                {
+                    block.Data.resize(_block);
+                    block.Source = block.Data.data();
 
-                lzo_uint decompressedSize{_block};
-                Bytes    decompressed(decompressedSize);
-                Bytes    work(info->MemoryDecompress);
-                int      result{};
+                    if (!input.Read(block.Data.data(), block.Data.size(), block.Size))
+                    {
+                        Message(_T("Error reading input"));
+                        pipeline.Finish();
 
-                try
+                        return Error(std::errc::io_error);
+                    }
+                }
+
+                read = block.Size;
+                offset += read;
+
+                if (select && read)
                 {
-                    result = info->FunctionDecompress(
-                        input.data(), input.size(), &decompressed[0], &decompressedSize, work.data());
+                    info   = SelectFormat(Sample(block.Source, block.Size));
+                    select = false;
                 }
-                catch (std::exception&)
+
+                if (read && pipeline.Push(std::move(block)) != std::errc{})
                 {
-                    result = -1;
+                    break;
                 }
+            } while (read == _block);
+
+            const auto error{pipeline.Finish()};
+
+            if (error != std::errc{})
+            {
+                return Error(error);
+            }
+
+            if (_index)
+            {
+                const auto indexSize{index.size() * sizeof(LZOIndexEntry)};
+                const auto indexHash{LZOHash::Hash(_checksum, (const byte*)index.data(), indexSize)};
+                Bytes      block(LZOHeader64::Size(indexSize));
+                const auto header{(LZOHeader64*)block.data()};
+
+                memcpy_s(header->Data(), indexSize, index.data(), indexSize);
+                header->Initialize(LZOFormat::Id::Index, indexSize, indexSize, indexHash, indexHash, 0, _checksum);
 
-                if (result == LZO_E_OK)
+                if (!output.Write(block.data(), block.size()))
                 {
-                    decompressed.resize(decompressedSize);
+                    Message(_T("Error writing output"));
 
-                    return Output(decompressed);
+                    return Error(std::errc::bad_address);
                 }
+            }
 
-                return Error(std::errc::illegal_byte_sequence);
+            trailer.Initialize(LZOFormat::Id::Stream, trailer.SourceSize, trailer.DestinationSize, trailer.SourceHash,
+                trailer.DestinationHash,
+                ((_index) ? LZOHeader64::FlagIndex : 0) | ((_optimize) ? LZOHeader64::FlagOptimized : 0), _checksum);
+
+            if (!output.Write(&trailer, LZOHeader64::Size()) || !output.Flush())
+            {
+                Message(_T("Error writing output"));
+
+                return Error(std::errc::bad_address);
+            }
+            if (_verbose)
+            {
+                statistics.Print(_T("Compressed"), Access(input, &output));
             }
 
-            const auto header{LZOHeader::Header(input.data(), input.size(), true)};
+            return Error({});
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    // Samples of data for SelectFormat (SampleCount pieces of SampleSize spread over data)
+    Bytes Sample(const byte* data, const size_t size) const
+    {
+        if (size <= SampleCount * SampleSize)
+        {
+            return Bytes(data, data + size);
+        }
+
+        Bytes sample;
 
-            if (header)
+        for (uint32_t index{}; index < SampleCount; ++index)
+        {
+            const auto offset{(size - SampleSize) / (SampleCount - 1) * index};
+
+            sample.insert(sample.end(), data + offset, data + offset + SampleSize);
+        }
+
+        return sample;
+    }
+
+    // Samples of a seekable input for SelectFormat, the input is rewound
+    Bytes Sample(LZOFile& input) const
+    {
+        uint64_t size{};
+        Bytes    sample;
+        size_t   read{};
+
+        if (input.Size(size))
+        {
+            for (uint32_t index{}; index < SampleCount; ++index)
             {
-                if (header->FormatId == LZOFormat::Id::None)
-                {
-                    return Output(input, LZOHeader::Size(0));
-                }
+                const auto offset{(size > SampleSize) ? (size - SampleSize) / (SampleCount - 1) * index : 0};
+                const auto used{sample.size()};
 
-                const auto info{LZOFormat::FormatInfo(header->FormatId)};
+                sample.resize(used + SampleSize);
 
-                if (!info || !info->FunctionDecompress)
-                {
-                    return Error(std::errc::not_supported);
-                }
-                if (header->SourceHash != 0 && header->SourceHash != lzo_adler32(0, header->Data(), header->SourceSize))
+                if (!input.Seek(offset) || !input.Read(sample.data() + used, SampleSize, read))
                 {
-                    return Error(std::errc::illegal_byte_sequence);
+                    read = 0;
                 }
 
-                lzo_uint decompressedSize{header->DestinationSize};
-                Bytes    decompressed(decompressedSize);
-                Bytes    work(info->MemoryDecompress);
-                int      result{};
+                sample.resize(used + read);
 
-                try
+                if (size <= SampleCount * SampleSize)
                 {
-                    result = info->FunctionDecompress(
-                        header->Data(), header->SourceSize, &decompressed[0], &decompressedSize, work.data());
-                }
-                catch (std::exception&)
-                {
-                    result = -1;
+                    break;
                 }
+            }
+        }
 
-                if (result == LZO_E_OK)
-                {
-                    if (header->DestinationHash != 0 &&
-                        header->DestinationHash != lzo_adler32(0, decompressed.data(), decompressedSize))
-                    {
-                        return Error(std::errc::illegal_byte_sequence);
-                    }
+        input.Seek(0);
 
-                    decompressed.resize(decompressedSize);
+        return sample;
+    }
 
-                    return Output(decompressed);
-                }
+    // Selects the format for -f auto by compressing the sample (in pieces of SampleSize) with all formats: the best
+    // ratio with at least _targetSpeed MB/s or the fastest with at most _targetRatio percent (if none meets the target
+    // the fastest or the best ratio)
+    const LZOFormat::Info* SelectFormat(const Bytes& sample)
+    {
+        const auto    targetSpeed{(_targetSpeed) ? _targetSpeed : DefaultTargetSpeed};
+        LZOFormat::Id selected{};
+        LZOFormat::Id fallback{};
+        double        selectedSpeed{};
+        double        selectedRatio{};
+        double        fallbackSpeed{};
+        double        fallbackRatio{};
+        Bytes         compressed(LZOCodec::CompressedSize(SampleSize));
+        Bytes         work;
+
+        for (const auto& format : LZOFormat::FormatIds())
+        {
+            const auto info{LZOFormat::FormatInfo(format.second)};
 
-                return Error(std::errc::bad_address);
+            if (sample.empty() || !info || !info->FunctionCompress)
+            {
+                continue;
+            }
+            if (work.size() < info->MemoryCompress)
+            {
+                work.resize(info->MemoryCompress);
+            }
+
+            const auto start{std::chrono::steady_clock::now()};
+            size_t     total{};
+            bool       valid{true};
+
+            for (size_t offset{}; offset < sample.size() && valid; offset += SampleSize)
+            {
+                const auto size{std::min<size_t>(SampleSize, sample.size() - offset)};
+                lzo_uint   compressedSize{LZOCodec::CompressedSize(size)};
+
+                valid = info->FunctionCompress(
+                            sample.data() + offset, size, compressed.data(), &compressedSize, work.data()) == LZO_E_OK;
+                total += std::min<size_t>(compressedSize, size);
+            }
+
+            const auto seconds{Seconds(start)};
+            const auto speed{(seconds > 0) ? sample.size() / (1024.0 * 1024.0) / seconds : 1e9};
+            const auto ratio{100.0 * total / sample.size()};
+            const auto meets{(_targetRatio) ? ratio <= _targetRatio : speed >= targetSpeed};
+            const auto better{(_targetRatio) ? speed > selectedSpeed : ratio < selectedRatio};
+
+            if (!valid)
+            {
+                continue;
+            }
+            if (meets && (selected == LZOFormat::Id{} || better))
+            {
+                selected      = format.second;
+                selectedSpeed = speed;
+                selectedRatio = ratio;
+            }
+            if (fallback == LZOFormat::Id{} || ((_targetRatio) ? ratio < fallbackRatio : speed > fallbackSpeed))
+            {
+                fallback      = format.second;
+                fallbackSpeed = speed;
+                fallbackRatio = ratio;
             }
         }
-        catch (std::exception&)
+
+        if (selected == LZOFormat::Id{})
         {
-            return Error(std::errc::not_enough_memory);
+            selected      = fallback;
+            selectedSpeed = fallbackSpeed;
+            selectedRatio = fallbackRatio;
+        }
+        if (selected != LZOFormat::Id{})
+        {
+            _format = selected;
+        }
+        if (_verbose)
+        {
+            std::tcerr << _T("Format ") << LZOFormat::FormatInfo(_format)->Name << _T(" (") << std::fixed
+                       << std::setprecision(2) << selectedSpeed << _T(" MB/s, ") << selectedRatio
+                       << _T(" % of the samples)") << std::endl;
         }
 
-        return Error({});
+        return LZOFormat::FormatInfo(_format);
     }
 
-    int Info()
+    // Compresses data behind a header into block (stored if not compressible), returns the block size. With _optimize
+    // work holds the data decompressed by the optimizer behind the work memory of the format. A block of a stream has a
+    // header with 64 bit sizes, so a stream cut after any block is detected by its missing trailer.
+    size_t CompressBlock(const LZOFormat::Id format, const byte* data, const size_t size, Bytes& block, Bytes& work,
+        const bool stream = false)
+    {
+        const auto info{LZOFormat::FormatInfo(format)};
+        const auto optimizeSize{(_optimize && info->FunctionOptimize) ? size : 0};
+
+        if (block.size() < LZOCodec::BlockSize(size))
+        {
+            block.resize(LZOCodec::BlockSize(size));
+        }
+        if (work.size() < info->MemoryCompress + optimizeSize)
+        {
+            work.resize(info->MemoryCompress + optimizeSize);
+        }
+
+        return LZOCodec::Compress(format, data, size, block.data(), block.size(), work.data(), _limitLess, _checksum,
+            Dictionary(), _level, (optimizeSize) ? work.data() + info->MemoryCompress : nullptr, stream);
+    }
+
+    int Decompress()
     {
+        if (!_headerLess)
+        {
+            return DecompressBlocks();
+        }
+
         const auto input{Input()};
 
         if (input.empty())
@@ -320,106 +773,2325 @@ public:
             return _error;
         }
 
-        auto header{LZOHeader::Header(input.data(), input.size())};
-
-        if (!header)
+        try
         {
-            Output("Header (not available)");
+            // Headerless data has no hash to verify it, so it is decompressed safe unless --decoder fast or asm trusts it
+            const auto info{LZOFormat::FormatInfo(_format)};
+            const auto decoder{(_decoderSelected) ? _decoder : LZOFormat::Decoder::Safe};
+            const auto decompress{(info) ? info->Decompressor(decoder, true) : nullptr};
 
-            return Error(std::errc::illegal_byte_sequence);
-        }
+            if (!info || !info->FunctionDecompress || (!_dictionary.empty() && !info->FunctionDecompressDict) ||
+                (_dictionary.empty() && !decompress))
+            {
+                return Error(std::errc::not_supported);
+            }
 
-        std::stringstream stream;
-        auto              valid{header->Valid()};
-        auto              info{LZOFormat::FormatInfo(header->FormatId)};
+            lzo_uint decompressedSize{_block};
+            Bytes    decompressed(decompressedSize);
+            Bytes    work(info->MemoryDecompress);
+            int      result{};
 
-        stream << "[0x00] HeaderId        :" << Hex(header->HeaderId) << Ok(header->HeaderId == LZOHeaderId)
-               << std::endl;
-        stream << "[0x04] FormatId        :" << Hex(header->FormatId) << " " << ((info) ? info->Name : "Unknown")
-               << std::endl;
-        stream << "[0x08] SourceSize      :" << Hex(header->SourceSize) << " " << header->SourceSize
-               << Ok(input.size() >= LZOHeader::Size(header->SourceSize)) << std::endl;
-        stream << "[0x0c] DestinationSize :" << Hex(header->DestinationSize) << " " << header->DestinationSize
-               << std::endl;
-        stream << "[0x10] SourceHash      :" << Hex(header->SourceHash)
-               << Ok(input.size() >= LZOHeader::Size(header->SourceSize) &&
-                      header->SourceHash == lzo_adler32(0, header->Data(), header->SourceSize))
+            try
+            {
+                result = (_dictionary.empty())
+                             ? decompress(input.data(), input.size(), &decompressed[0], &decompressedSize, work.data())
+                             : info->FunctionDecompressDict(input.data(), input.size(), &decompressed[0],
+                                   &decompressedSize, work.data(), _dictionary.data(), _dictionary.size());
+            }
+            catch (std::exception&)
+            {
+                result = -1;
+            }
+
+            if (result == LZO_E_OK)
+            {
+                decompressed.resize(decompressedSize);
+
+                return Output(decompressed);
+            }
+
+            return Error(std::errc::illegal_byte_sequence);
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+
+        return Error({});
+    }
+
+    // Decompresses a sequence of header/ data blocks (a single header file is a stream of one block),
+    // blocks are verified and decompressed on _threads workers and written in input order.
+    // A stream of more than one block or of blocks with 64 bit headers has to end with a trailer that matches the
+    // blocks and has no block larger than MaximumBlockSize, an index is skipped.
+    // The command test only verifies: nothing is written, summary gets the sizes and hashes of the blocks.
+    int DecompressBlocks(LZOHeader64* summary = nullptr)
+    {
+        const auto verify{_command == Command::Test};
+        LZOFile    input;
+        LZOFile    output;
+        uint64_t   size{};
+
+        if (!OpenInput(input, _async, _direct))
+        {
+            return _error;
+        }
+
+        auto mapped{_mapped && !_direct && !verify && !_output.empty() && DestinationSize(input, size)};
+
+        if (!verify && !OpenOutput(output, mapped, (mapped) ? 0 : _async, _direct))
+        {
+            return _error;
+        }
+        if (_sparse && !verify && !mapped)
+        {
+            output.Sparse();
+        }
+
+        mapped = mapped && output.CreateMapping(true, size);
+
+        try
+        {
+            const auto         dictionary{Dictionary()};
+            const auto         decoder{Decoder()};
+            Statistics         statistics(Threads());
+            LZOHeader64        stream;
+            LZOHeader64        trailer;
+            size_t             blocks{};
+            uint64_t           largest{};
+            bool               streamed{};
+            std::vector<Bytes> works(Threads());
+            LZOPipeline<Block> pipeline(
+                works.size(),
+                [&](Block& block, const size_t worker) {
+                    return WithHeader(block.Compressed.data(), [&](const auto* header) {
+                        return DecompressBlock(header, block.View.Data(), block.Data, works[worker], block.Result,
+                            block.Size, dictionary, decoder);
+                    });
+                },
+                [&](Block& block) {
+                    if (!block.View.Data() && !verify && !output.Write(block.Result, block.Size))
+                    {
+                        Message(_T("Error writing output"));
+
+                        return std::errc::bad_address;
+                    }
+
+                    statistics.Add(block.CompressedSize, block.Size,
+                        WithHeader(block.Compressed.data(), [](const auto* header) {
+                            return header->FormatId == LZOFormat::Id::None;
+                        }));
+                    block.View = {};
+
+                    return std::errc{};
+                },
+                _stream);
+
+            for (;;)
+            {
+                auto       block{pipeline.Acquire()};
+                const auto error{ReadBlock(input, block)};
+
+                if (error != std::errc{})
+                {
+                    pipeline.Finish();
+
+                    return Error(error);
+                }
+                if (!block.CompressedSize)
+                {
+                    break;
+                }
+
+                const auto header{LZOHeader64::Header(block.Compressed.data(), block.CompressedSize)};
+
+                if (header && header->FormatId == LZOFormat::Id::Stream)
+                {
+                    trailer = *header;
+                    break;
+                }
+                if (header &&
+                    (header->FormatId == LZOFormat::Id::Index || header->FormatId == LZOFormat::Id::Directory))
+                {
+                    continue;
+                }
+
+                const auto offset{stream.DestinationSize};
+
+                WithHeader(block.Compressed.data(), [&](const auto* header) {
+                    stream.Append(header);
+                    largest = std::max<uint64_t>(largest, header->DestinationSize);
+                });
+
+                // The decompressed size is untrusted: a block of a stream larger than MaximumBlockSize is rejected
+                // before its buffer is allocated, only a single header file has a block of any size. A block with a 64
+                // bit header is a block of a stream, even if it is the only one.
+                streamed = streamed || header;
+
+                if ((++blocks > 1 || streamed) && largest > MaximumBlockSize)
+                {
+                    pipeline.Finish();
+
+                    return Error(std::errc::illegal_byte_sequence);
+                }
+
+                if (mapped)
+                {
+                    if (stream.DestinationSize > size)
+                    {
+                        pipeline.Finish();
+
+                        return Error(std::errc::illegal_byte_sequence);
+                    }
+
+                    block.View = output.Map(offset, (size_t)(stream.DestinationSize - offset));
+
+                    if (stream.DestinationSize > offset && !block.View.Data())
+                    {
+                        Message(_T("Error mapping output"));
+                        pipeline.Finish();
+
+                        return Error(std::errc::not_enough_memory);
+                    }
+                }
+
+                if (pipeline.Push(std::move(block)) != std::errc{})
+                {
+                    break;
+                }
+            }
+
+            auto error{pipeline.Finish()};
+
+            if (error == std::errc::invalid_argument)
+            {
+                Message(_T("Dictionary missing or not matching"));
+            }
+            if (error == std::errc{} && (trailer.Valid() || blocks > 1 || streamed) &&
+                (trailer.SourceSize != stream.SourceSize || trailer.DestinationSize != stream.DestinationSize ||
+                    trailer.SourceHash != stream.SourceHash || trailer.DestinationHash != stream.DestinationHash))
+            {
+                error = std::errc::illegal_byte_sequence;
+            }
+            if (error == std::errc{} && !output.Flush())
+            {
+                Message(_T("Error writing output"));
+
+                error = std::errc::bad_address;
+            }
+            if (_verbose && error == std::errc{})
+            {
+                statistics.Print(_T("Decompressed"), Access(input, (verify) ? nullptr : &output));
+            }
+            if (summary)
+            {
+                *summary = stream;
+            }
+
+            return Error(error);
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    // Verifies compressed files without writing the decompressed data: the header (HeaderHash), compressed and
+    // decompressed data (SourceHash, DestinationHash) of each block and the trailer. Each block is decompressed into
+    // a buffer of its worker that is reused. The blocks of a file are verified on _threads workers, with --batch the
+    // files of a list (one path per line) are verified concurrently. Reports each file and the throughput (MB/s of
+    // the decompressed data).
+    int Test()
+    {
+        struct File
+        {
+            std::tstring Path;
+            LZOHeader64  Summary;
+            std::tstring Messages;
+            int          Error{};
+        };
+
+        if (_headerLess)
+        {
+            Message(_T("Test needs a header"));
+
+            return Error(std::errc::invalid_argument);
+        }
+
+        try
+        {
+            std::vector<std::tstring> paths;
+
+            if (_batch)
+            {
+                LZOFile list;
+
+                if (!OpenInput(list))
+                {
+                    return _error;
+                }
+                for (const auto& line : ReadList(list))
+                {
+                    paths.push_back(std::tstring(CA2T(line.data(), CP_UTF8)));
+                }
+            }
+            else
+            {
+                paths.push_back(_input);
+            }
+
+            const auto        start{std::chrono::steady_clock::now()};
+            uint64_t          files{};
+            uint64_t          failed{};
+            uint64_t          size{};
+            uint64_t          decompressedSize{};
+            std::stringstream stream;
+            LZOPipeline<File> pipeline(
+                (_batch) ? Threads() : 1,
+                [&](File& file, const size_t) {
+                    LZOCommand         command{*this};
+                    std::tstringstream messages;
+
+                    command._input    = file.Path;
+                    command._batch    = false;
+                    command._verbose  = false;
+                    command._threads  = (_batch) ? 0 : _threads;
+                    command._messages = &messages;
+                    file.Summary      = {};
+                    file.Error        = command.DecompressBlocks(&file.Summary);
+                    file.Messages     = messages.str();
+
+                    return std::errc{};
+                },
+                [&](File& file) {
+                    const std::string name{(file.Path.empty()) ? "<stdin>" : CT2A(file.Path.data(), CP_UTF8)};
+
+                    ++files;
+                    size += file.Summary.SourceSize;
+                    decompressedSize += file.Summary.DestinationSize;
+
+                    if (file.Error)
+                    {
+                        ++failed;
+                        stream << "Failed " << name << " (" << Reason((std::errc)file.Error) << ")" << std::endl;
+                    }
+                    else
+                    {
+                        // Blocks compressed with -k none have no hashes (0) to verify
+                        const auto hashes{file.Summary.SourceHash || file.Summary.DestinationHash};
+
+                        stream << "Ok     " << name << " " << file.Summary.SourceSize << " bytes ("
+                               << file.Summary.DestinationSize << " bytes decompressed"
+                               << ((hashes || !file.Summary.SourceSize) ? "" : ", no hashes") << ")" << std::endl;
+                    }
+                    stream << CT2A(file.Messages.data(), CP_UTF8);
+
+                    return std::errc{};
+                });
+
+            for (const auto& path : paths)
+            {
+                auto file{pipeline.Acquire()};
+
+                file.Path = path;
+                pipeline.Push(std::move(file));
+            }
+
+            pipeline.Finish();
+
+            const auto seconds{Seconds(start)};
+
+            stream << "Tested " << files << " file(s), " << failed << " failed, " << size << " bytes ("
+                   << decompressedSize << " bytes decompressed) in " << std::fixed << std::setprecision(3) << seconds
+                   << " s, " << std::setprecision(2)
+                   << ((seconds > 0) ? decompressedSize / (1024.0 * 1024.0) / seconds : 0) << " MB/s" << std::endl;
+
+            const auto error{Output(stream.str())};
+
+            return (failed) ? Error(std::errc::io_error) : error;
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    // Reason of a failed test
+    static std::string Reason(const std::errc error)
+    {
+        switch (error)
+        {
+            case std::errc::illegal_byte_sequence:
+                return "hash or size mismatch";
+            case std::errc::bad_address:
+                return "corrupt compressed data";
+            case std::errc::invalid_argument:
+                return "dictionary missing or not matching";
+            case std::errc::not_supported:
+                return "unknown format or no safe decompressor";
+            default:
+                return std::generic_category().message((int)error);
+        }
+    }
+
+    // Size of all decompressed data of a seekable input (from a single header or the trailer), input is rewound
+    bool DestinationSize(LZOFile& input, uint64_t& size)
+    {
+        Bytes    header;
+        size_t   headerSize{};
+        uint64_t fileSize{};
+
+        size = 0;
+
+        if (!input.Seekable() || !input.Size(fileSize) || ReadHeader(input, header, headerSize) != std::errc{} ||
+            !headerSize)
+        {
+            input.Seek(0);
+
+            return false;
+        }
+
+        const auto trailer{LZOHeader64::Header(header.data(), headerSize)};
+
+        if (!trailer || trailer->FormatId != LZOFormat::Id::Stream)
+        {
+            WithHeader(header.data(), [&](const auto* first) {
+                if (fileSize == headerSize + first->SourceSize)
+                {
+                    size = first->DestinationSize;
+                }
+            });
+
+            if (!size && fileSize >= LZOHeader64::Size() && input.Seek(fileSize - LZOHeader64::Size()) &&
+                ReadHeader(input, header, headerSize) == std::errc{})
+            {
+                const auto last{LZOHeader64::Header(header.data(), headerSize)};
+
+                size = (last && last->FormatId == LZOFormat::Id::Stream) ? last->DestinationSize : 0;
+            }
+        }
+
+        return input.Seek(0) && size;
+    }
+
+    // Reads the block index of a seekable input from the index before the trailer or else from the block headers
+    std::errc ReadIndex(LZOFile& input, std::vector<LZOIndexEntry>& index)
+    {
+        Block      block;
+        const auto error{ReadRecord(input, LZOHeader64::FlagIndex, LZOFormat::Id::Index, block)};
+
+        index.clear();
+
+        if (error != std::errc{})
+        {
+            return error;
+        }
+        if (block.CompressedSize)
+        {
+            const auto header{LZOHeader64::Header(block.Compressed.data(), block.CompressedSize)};
+
+            if (header->SourceSize % sizeof(LZOIndexEntry))
+            {
+                return std::errc::illegal_byte_sequence;
+            }
+
+            const auto entries{(const LZOIndexEntry*)header->Data()};
+
+            index.assign(entries, entries + header->SourceSize / sizeof(LZOIndexEntry));
+
+            return {};
+        }
+
+        return ScanIndex(input, 0, UINT64_MAX, index);
+    }
+
+    // Reads the directory of a seekable archive
+    std::errc ReadDirectory(LZOFile& input, std::vector<Member>& members)
+    {
+        Block      block;
+        const auto error{ReadRecord(input, LZOHeader64::FlagDirectory, LZOFormat::Id::Directory, block)};
+
+        members.clear();
+
+        if (error != std::errc{} || !block.CompressedSize)
+        {
+            Message(_T("Input is not an archive"));
+
+            return (error != std::errc{}) ? error : std::errc::illegal_byte_sequence;
+        }
+
+        const auto header{LZOHeader64::Header(block.Compressed.data(), block.CompressedSize)};
+        const auto data{header->Data()};
+        const auto size{(size_t)header->SourceSize};
+
+        for (size_t offset{}; offset < size;)
+        {
+            Member member;
+
+            if (size - offset < sizeof(LZOArchiveEntry))
+            {
+                return std::errc::illegal_byte_sequence;
+            }
+
+            memcpy(&member.Entry, data + offset, sizeof(LZOArchiveEntry));
+            offset += sizeof(LZOArchiveEntry);
+
+            if (size - offset < member.Entry.NameSize)
+            {
+                return std::errc::illegal_byte_sequence;
+            }
+
+            member.Name.assign((const char*)data + offset, member.Entry.NameSize);
+            offset += member.Entry.NameSize;
+            members.push_back(std::move(member));
+        }
+
+        return {};
+    }
+
+    // Reads the block index of the archive member _member from its block headers (the rest of the archive is not read)
+    std::errc ReadMember(LZOFile& input, std::vector<LZOIndexEntry>& index)
+    {
+        std::vector<Member> members;
+        const auto          error{ReadDirectory(input, members)};
+        const std::string   name{CT2A(_member.data(), CP_UTF8)};
+
+        index.clear();
+
+        if (error != std::errc{})
+        {
+            return error;
+        }
+
+        const auto member{std::find_if(members.begin(), members.end(), [&](const auto& member) {
+            return member.Name == name;
+        })};
+
+        if (member == members.end())
+        {
+            Message(_T("Unknown member "), _member.data());
+
+            return std::errc::no_such_file_or_directory;
+        }
+
+        const auto& entry{member->Entry};
+        const auto  scanned{ScanIndex(input, entry.Offset, entry.Offset + entry.SourceSize, index)};
+        uint64_t    sourceSize{};
+        uint64_t    destinationSize{};
+
+        if (scanned != std::errc{})
+        {
+            return scanned;
+        }
+
+        for (const auto& block : index)
+        {
+            sourceSize += block.SourceSize;
+            destinationSize += block.DestinationSize;
+        }
+
+        if (sourceSize != entry.SourceSize || destinationSize != entry.DestinationSize)
+        {
+            return std::errc::illegal_byte_sequence;
+        }
+
+        return {};
+    }
+
+    // Reads the record (FormatId formatId) that a trailer with flag has at SourceSize into block, CompressedSize is 0
+    // if the input has no such trailer
+    std::errc ReadRecord(LZOFile& input, const uint32_t flag, const LZOFormat::Id formatId, Block& block)
+    {
+        Bytes    header;
+        size_t   size{};
+        uint64_t fileSize{};
+
+        block.CompressedSize = 0;
+
+        if (!input.Size(fileSize))
+        {
+            return std::errc::io_error;
+        }
+        if (fileSize < LZOHeader64::Size() || !input.Seek(fileSize - LZOHeader64::Size()) ||
+            ReadHeader(input, header, size) != std::errc{})
+        {
+            return {};
+        }
+
+        const auto trailer{LZOHeader64::Header(header.data(), size)};
+
+        if (!trailer || trailer->FormatId != LZOFormat::Id::Stream || !(trailer->Flags & flag))
+        {
+            return {};
+        }
+        if (!input.Seek(trailer->SourceSize) || ReadBlock(input, block) != std::errc{})
+        {
+            block.CompressedSize = 0;
+
+            return std::errc::illegal_byte_sequence;
+        }
+
+        const auto record{LZOHeader64::Header(block.Compressed.data(), block.CompressedSize)};
+
+        if (!record || record->FormatId != formatId || record->SourceSize > SIZE_MAX ||
+            record->SourceHash != LZOHash::Hash(record->Checksum(), record->Data(), (size_t)record->SourceSize))
+        {
+            block.CompressedSize = 0;
+
+            return std::errc::illegal_byte_sequence;
+        }
+
+        return {};
+    }
+
+    // Collects the blocks from offset up to end (or the trailer) of a seekable input from their headers
+    std::errc ScanIndex(LZOFile& input, uint64_t offset, const uint64_t end, std::vector<LZOIndexEntry>& index)
+    {
+        Bytes  header;
+        size_t size{};
+
+        while (offset < end)
+        {
+            if (!input.Seek(offset))
+            {
+                return std::errc::io_error;
+            }
+
+            const auto error{ReadHeader(input, header, size)};
+
+            if (error != std::errc{} || !size)
+            {
+                return error;
+            }
+
+            const auto other{LZOHeader64::Header(header.data(), size)};
+
+            if (other && other->FormatId == LZOFormat::Id::Stream)
+            {
+                return {};
+            }
+
+            LZOIndexEntry entry{offset};
+
+            WithHeader(header.data(), [&](const auto* block) {
+                entry.SourceSize      = size + block->SourceSize;
+                entry.DestinationSize = block->DestinationSize;
+            });
+
+            if (!other || (other->FormatId != LZOFormat::Id::Index && other->FormatId != LZOFormat::Id::Directory))
+            {
+                index.push_back(entry);
+            }
+
+            offset += entry.SourceSize;
+        }
+
+        return {};
+    }
+
+    // Decompresses _length bytes (0: up to the end) at _offset of the decompressed data, from a seekable input only
+    // the blocks covering the range are read (located by the index or the block headers). With _member the range is
+    // taken from that member of an archive (located by the directory).
+    int Extract()
+    {
+        LZOFile input;
+        LZOFile output;
+
+        if (!OpenInput(input))
+        {
+            return _error;
+        }
+        if (!_member.empty() && !input.Seekable())
+        {
+            Message(_T("Extracting a member needs an input file"));
+
+            return Error(std::errc::invalid_argument);
+        }
+        if (!OpenOutput(output))
+        {
+            return _error;
+        }
+        if (_sparse)
+        {
+            output.Sparse();
+        }
+
+        try
+        {
+            const auto end{(_length && _length <= UINT64_MAX - _offset) ? _offset + _length : UINT64_MAX};
+            const auto seekable{input.Seekable()};
+            std::vector<LZOIndexEntry> index;
+            Block                      block;
+            Bytes                      work;
+            uint64_t                   position{};
+            size_t                     next{};
+
+            if (seekable)
+            {
+                const auto error{(_member.empty()) ? ReadIndex(input, index) : ReadMember(input, index)};
+
+                if (error != std::errc{})
+                {
+                    return Error(error);
+                }
+            }
+
+            while (position < end)
+            {
+                const LZOIndexEntry* entry{};
+
+                if (seekable)
+                {
+                    while (next < index.size() && position + index[next].DestinationSize <= _offset)
+                    {
+                        position += index[next++].DestinationSize;
+                    }
+                    if (next == index.size())
+                    {
+                        break;
+                    }
+
+                    entry = &index[next++];
+
+                    if (!input.Seek(entry->Offset))
+                    {
+                        return Error(std::errc::io_error);
+                    }
+                }
+
+                const auto error{ReadBlock(input, block)};
+
+                if (error != std::errc{})
+                {
+                    return Error(error);
+                }
+                if (!block.CompressedSize)
+                {
+                    break;
+                }
+
+                const auto other{LZOHeader64::Header(block.Compressed.data(), block.CompressedSize)};
+
+                if (other && other->FormatId == LZOFormat::Id::Stream)
+                {
+                    break;
+                }
+                if (other && (other->FormatId == LZOFormat::Id::Index || other->FormatId == LZOFormat::Id::Directory))
+                {
+                    continue;
+                }
+
+                const auto size{WithHeader(block.Compressed.data(), [](const auto* header) {
+                    return (uint64_t)header->DestinationSize;
+                })};
+
+                if (entry && (entry->SourceSize != block.CompressedSize || entry->DestinationSize != size))
+                {
+                    return Error(std::errc::illegal_byte_sequence);
+                }
+                if (position + size > _offset)
+                {
+                    const auto result{WithHeader(block.Compressed.data(), [&](const auto* header) {
+                        return DecompressBlock(
+                            header, nullptr, block.Data, work, block.Result, block.Size, Dictionary(), Decoder());
+                    })};
+
+                    if (result == std::errc::invalid_argument)
+                    {
+                        Message(_T("Dictionary missing or not matching"));
+                    }
+                    if (result != std::errc{})
+                    {
+                        return Error(result);
+                    }
+
+                    const auto first{(size_t)(std::max<uint64_t>(position, _offset) - position)};
+                    const auto last{(size_t)(std::min<uint64_t>(position + size, end) - position)};
+
+                    if (!output.Write(block.Result + first, last - first))
+                    {
+                        Message(_T("Error writing output"));
+
+                        return Error(std::errc::bad_address);
+                    }
+                }
+
+                position += size;
+            }
+
+            if (!output.Flush())
+            {
+                Message(_T("Error writing output"));
+
+                return Error(std::errc::bad_address);
+            }
+
+            return Error({});
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    // Reads a header (LZOHeader or LZOHeader64) into data, size is 0 at the end of input
+    std::errc ReadHeader(LZOFile& input, Bytes& data, size_t& size)
+    {
+        size_t read{};
+
+        if (data.size() < LZOHeader64::Size())
+        {
+            data.resize(LZOHeader64::Size());
+        }
+
+        size = 0;
+
+        if (!input.Read(data.data(), LZOHeader::Size(), read))
+        {
+            Message(_T("Error reading input"));
+
+            return std::errc::io_error;
+        }
+        if (!read)
+        {
+            return {};
+        }
+        if (read == LZOHeader::Size() && LZOHeader64::Identifies(*(const uint32_t*)data.data()))
+        {
+            if (!input.Read(data.data() + read, LZOHeader64::Size() - read, read))
+            {
+                Message(_T("Error reading input"));
+
+                return std::errc::io_error;
+            }
+            if (!LZOHeader64::Header(data.data(), LZOHeader::Size() + read, true))
+            {
+                return std::errc::illegal_byte_sequence;
+            }
+
+            size = LZOHeader64::Size();
+
+            return {};
+        }
+        if (!LZOHeader::Header(data.data(), read, true))
+        {
+            return std::errc::illegal_byte_sequence;
+        }
+
+        size = LZOHeader::Size();
+
+        return {};
+    }
+
+    // Reads the next header and its data into block.Compressed (CompressedSize is 0 at the end of input)
+    std::errc ReadBlock(LZOFile& input, Block& block)
+    {
+        size_t     size{};
+        const auto error{ReadHeader(input, block.Compressed, size)};
+
+        block.CompressedSize = 0;
+
+        if (error != std::errc{} || !size)
+        {
+            return error;
+        }
+
+        const auto trailer{LZOHeader64::Header(block.Compressed.data(), size)};
+
+        if (trailer && trailer->FormatId == LZOFormat::Id::Stream)
+        {
+            block.CompressedSize = size;
+
+            return {};
+        }
+
+        const auto sourceSize{WithHeader(block.Compressed.data(), [](const auto* header) {
+            return (uint64_t)header->SourceSize;
+        })};
+
+        if (sourceSize > SIZE_MAX - size)
+        {
+            return std::errc::not_enough_memory;
+        }
+        if (block.Compressed.size() < size + sourceSize)
+        {
+            block.Compressed.resize(size + (size_t)sourceSize);
+        }
+
+        size_t read{};
+
+        if (!input.Read(block.Compressed.data() + size, (size_t)sourceSize, read) || read != sourceSize)
+        {
+            return std::errc::illegal_byte_sequence;
+        }
+
+        block.CompressedSize = size + (size_t)sourceSize;
+
+        return {};
+    }
+
+    // Verifies and decompresses one block into target (DestinationSize bytes) or decompressed (with the slack of the
+    // Asm decoder), without target stored data is passed through without copying
+    template <typename Header>
+    static std::errc DecompressBlock(const Header* header, byte* target, Bytes& decompressed, Bytes& work,
+        const byte*& data, size_t& size, const LZODictionary& dictionary = {},
+        const LZOFormat::Decoder decoder = LZOFormat::Decoder::Fast)
+    {
+        const auto info{LZOFormat::FormatInfo(header->FormatId)};
+
+        if (header->DestinationSize > SIZE_MAX)
+        {
+            return std::errc::not_enough_memory;
+        }
+        auto targetSize{(target) ? (size_t)header->DestinationSize : 0};
+
+        if (!target && header->FormatId != LZOFormat::Id::None)
+        {
+            if (decompressed.size() < header->DestinationSize + LZOFormat::AsmSlack)
+            {
+                decompressed.resize((size_t)header->DestinationSize + LZOFormat::AsmSlack);
+            }
+
+            target     = decompressed.data();
+            targetSize = decompressed.size();
+        }
+        if (info && work.size() < info->MemoryDecompress)
+        {
+            work.resize(info->MemoryDecompress);
+        }
+
+        return LZOCodec::Decompress(header, target, targetSize, work.data(), data, size, dictionary, decoder);
+    }
+
+    // Calls function with the LZOHeader64 or LZOHeader at data
+    template <typename Function>
+    static auto WithHeader(const byte* data, Function function) -> decltype(function((const LZOHeader*)data))
+    {
+        if (LZOHeader64::Identifies(*(const uint32_t*)data))
+        {
+            return function(LZOHeader64::Header(data, LZOHeader64::Size()));
+        }
+
+        return function(LZOHeader::Header(data, LZOHeader::Size()));
+    }
+
+    // Shows the first header and the trailer of a block stream, data is only read to verify the first block
+    int Info()
+    {
+        LZOFile input;
+
+        if (!OpenInput(input))
+        {
+            return _error;
+        }
+
+        try
+        {
+            Bytes  first;
+            size_t size{};
+
+            if (ReadHeader(input, first, size) != std::errc{} || !size)
+            {
+                Output("Header (not available)");
+
+                return Error(std::errc::illegal_byte_sequence);
+            }
+
+            const auto trailer{LZOHeader64::Header(first.data(), size)};
+            const auto sourceSize{(trailer && trailer->FormatId == LZOFormat::Id::Stream)
+                                      ? 0
+                                      : WithHeader(first.data(), [](const auto* header) {
+                                            return (uint64_t)header->SourceSize;
+                                        })};
+            Bytes      buffer(BufferSize);
+            Bytes      last;
+            uint64_t   total{size};
+            LZOHash    sourceHash{WithHeader(first.data(), [](const auto* header) { return header->Checksum(); })};
+            size_t     read{};
+
+            // Data of the first block
+            while (total - size < sourceSize)
+            {
+                const auto chunk{(size_t)std::min<uint64_t>(buffer.size(), sourceSize - (total - size))};
+
+                if (!input.Read(buffer.data(), chunk, read) || !read)
+                {
+                    break;
+                }
+
+                sourceHash.Update(buffer.data(), read);
+                total += read;
+            }
+
+            // Trailer at the end of the input
+            uint64_t fileSize{};
+
+            if (input.Seekable() && input.Size(fileSize) && fileSize >= total + LZOHeader64::Size())
+            {
+                last.resize(LZOHeader64::Size());
+
+                if (input.Seek(fileSize - last.size()) && input.Read(last.data(), last.size(), read))
+                {
+                    last.resize(read);
+                }
+
+                total = fileSize;
+            }
+            else
+            {
+                while (input.Read(buffer.data(), buffer.size(), read) && read)
+                {
+                    last.insert(last.end(), buffer.begin(), buffer.begin() + read);
+                    last.erase(last.begin(), last.end() - std::min<size_t>(last.size(), LZOHeader64::Size()));
+                    total += read;
+                }
+            }
+
+            std::stringstream stream;
+
+            WithHeader(first.data(), [&](const auto* header) {
+                Info(stream, header, total - size >= sourceSize,
+                    total - size >= sourceSize && header->SourceHash == sourceHash.Value());
+            });
+            stream << Offset(size) << " ...              " << Hex64(total) << " " << total << std::endl;
+
+            const auto end{LZOHeader64::Header(last.data(), last.size(), true)};
+
+            if (end && end->FormatId == LZOFormat::Id::Stream && total > LZOHeader64::Size())
+            {
+                stream << "Trailer at" << Hex64(total - LZOHeader64::Size()) << std::endl;
+
+                const auto recorded{(end->Flags & (LZOHeader64::FlagIndex | LZOHeader64::FlagDirectory)) != 0};
+
+                Info(stream, end, recorded || end->SourceSize == total - LZOHeader64::Size(), false);
+            }
+
+            std::vector<LZOIndexEntry> index;
+
+            if (end && (end->Flags & LZOHeader64::FlagIndex) && input.Seekable() &&
+                ReadIndex(input, index) == std::errc{})
+            {
+                uint64_t smallest{UINT64_MAX};
+                uint64_t largest{};
+
+                for (const auto& entry : index)
+                {
+                    smallest = std::min<uint64_t>(smallest, entry.SourceSize);
+                    largest  = std::max<uint64_t>(largest, entry.SourceSize);
+                }
+
+                stream << "Index at" << Hex64(end->SourceSize) << " " << index.size() << " block(s)";
+                if (!index.empty())
+                {
+                    stream << ", " << index.front().DestinationSize << " bytes per block, " << smallest << " ... "
+                           << largest << " bytes compressed";
+                }
+                stream << std::endl;
+            }
+
+            std::vector<Member> members;
+
+            if (end && (end->Flags & LZOHeader64::FlagDirectory) && input.Seekable() &&
+                ReadDirectory(input, members) == std::errc{})
+            {
+                stream << "Directory at" << Hex64(end->SourceSize) << " " << members.size() << " member(s)"
+                       << std::endl;
+            }
+
+            return Output(stream.str());
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    template <typename Header>
+    static void Info(std::stringstream& stream, const Header* header, const bool complete, const bool sourceHash)
+    {
+        const auto info{LZOFormat::FormatInfo(header->FormatId)};
+
+        const auto checksum{LZOHash::Name(header->Checksum())};
+
+        stream << Offset(offsetof(Header, HeaderId)) << " HeaderId        :" << Hex(header->HeaderId) << " "
+               << ((checksum) ? checksum : "unknown") << Ok(Header::Identifies(header->HeaderId)) << std::endl;
+        stream << Offset(offsetof(Header, FormatId)) << " FormatId        :" << Hex(header->FormatId) << " "
+               << ((info) ? info->Name : "Unknown") << std::endl;
+        stream << Offset(offsetof(Header, SourceSize)) << " SourceSize      :" << Hex(header->SourceSize) << " "
+               << header->SourceSize << Ok(complete) << std::endl;
+        stream << Offset(offsetof(Header, DestinationSize)) << " DestinationSize :" << Hex(header->DestinationSize)
+               << " " << header->DestinationSize << std::endl;
+        stream << Offset(offsetof(Header, SourceHash)) << " SourceHash      :" << Hex(header->SourceHash)
+               << Ok(sourceHash) << std::endl;
+        stream << Offset(offsetof(Header, DestinationHash)) << " DestinationHash :" << Hex(header->DestinationHash)
                << std::endl;
-        stream << "[0x14] DestinationHash :" << Hex(header->DestinationHash) << std::endl;
-        stream << "[0x18] HeaderHash      :" << Hex(header->HeaderHash) << Ok(valid) << std::endl;
-        stream << "[0x1c] ...              " << Hex(input.size()) << " " << input.size() << std::endl;
+        if constexpr (std::is_same_v<Header, LZOHeader64>)
+        {
+            const auto record{header->FormatId == LZOFormat::Id::Stream || header->FormatId == LZOFormat::Id::Index ||
+                              header->FormatId == LZOFormat::Id::Directory};
+
+            stream << Offset(offsetof(Header, Flags)) << ((record) ? " Flags           :" : " DictionaryId    :")
+                   << Hex(header->Flags) << std::endl;
+        }
+        stream << Offset(offsetof(Header, HeaderHash)) << " HeaderHash      :" << Hex(header->HeaderHash)
+               << Ok(header->Valid()) << std::endl;
+    }
+
+    // Compresses/ decompresses each file of a list (_input or stdin, one path per line) to its own output: compress
+    // writes path.lzo, decompress path without .lzo (or path.out), into the directory _output if given. Files are
+    // spread across _threads workers, each file is processed like a single command (buffers and work memory are reused
+    // from the LZOArena pool), the summary shows files/s and MB/s of the input.
+    int Batch()
+    {
+        struct File
+        {
+            std::tstring Path;
+            std::tstring Output;
+            std::tstring Messages;
+            uint64_t     Size{};
+            uint64_t     OutputSize{};
+            int          Error{};
+        };
+
+        LZOFile input;
+
+        if (!OpenInput(input))
+        {
+            return _error;
+        }
+        if (!_output.empty() && !CreateDirectory(_output.data(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+        {
+            Message(_T("Error creating "), _output.data());
+
+            return Error(std::errc::no_such_file_or_directory);
+        }
+
+        try
+        {
+            const auto        list{ReadList(input)};
+            const auto        start{std::chrono::steady_clock::now()};
+            uint64_t          files{};
+            uint64_t          failed{};
+            uint64_t          inputSize{};
+            uint64_t          outputSize{};
+            std::stringstream stream;
+            std::stringstream failures;
+            LZOPipeline<File> pipeline(
+                Threads(),
+                [&](File& file, const size_t) {
+                    // A duplicate output is not written
+                    if (file.Error)
+                    {
+                        file.Size       = 0;
+                        file.OutputSize = 0;
+
+                        return std::errc{};
+                    }
+
+                    LZOCommand         command{*this};
+                    std::tstringstream messages;
+
+                    command._input    = file.Path;
+                    command._output   = file.Output;
+                    command._batch    = false;
+                    command._verbose  = false;
+                    command._threads  = 0;
+                    command._messages = &messages;
+                    file.Error        = (_command == Command::Compress) ? command.Compress() : command.Decompress();
+                    file.Size         = FileSize(file.Path);
+                    file.OutputSize   = FileSize(file.Output);
+                    file.Messages     = messages.str();
+
+                    return std::errc{};
+                },
+                [&](File& file) {
+                    ++files;
+                    inputSize += file.Size;
+                    outputSize += file.OutputSize;
+
+                    if (file.Error)
+                    {
+                        ++failed;
+                        failures << "Failed " << CT2A(file.Path.data(), CP_UTF8) << std::endl;
+                    }
+                    failures << CT2A(file.Messages.data(), CP_UTF8);
+
+                    return std::errc{};
+                });
+
+            // With -o the files of different directories may have the same output name (file names are not case
+            // sensitive), a later file would overwrite the output of the earlier one and is failed instead
+            const auto less{[](const std::tstring& first, const std::tstring& second) {
+                return _tcsicmp(first.data(), second.data()) < 0;
+            }};
+            std::set<std::tstring, decltype(less)> outputs(less);
+
+            for (const auto& line : list)
+            {
+                auto file{pipeline.Acquire()};
+
+                file.Path     = CA2T(line.data(), CP_UTF8);
+                file.Output   = BatchOutput(file.Path);
+                file.Error    = (outputs.insert(file.Output).second) ? 0 : (int)std::errc::file_exists;
+                file.Messages = (file.Error) ? _T("Duplicate output ") + file.Output + _T("\n") : std::tstring{};
+                pipeline.Push(std::move(file));
+            }
+
+            pipeline.Finish();
+
+            const auto seconds{Seconds(start)};
+
+            stream << "Batch " << files << " file(s), " << failed << " failed, " << inputSize << " bytes to "
+                   << outputSize << " bytes in " << std::fixed << std::setprecision(3) << seconds << " s, "
+                   << std::setprecision(2) << ((seconds > 0) ? files / seconds : 0) << " files/s, "
+                   << ((seconds > 0) ? inputSize / (1024.0 * 1024.0) / seconds : 0) << " MB/s" << std::endl
+                   << failures.str();
+
+            // -o is the directory of the outputs, the summary is written to stdout
+            _output.clear();
+
+            const auto error{Output(stream.str())};
+
+            return (failed) ? Error(std::errc::io_error) : error;
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    // Output name of a batch file
+    std::tstring BatchOutput(const std::tstring& path) const
+    {
+        const std::tstring extension{_T(".lzo")};
+        auto               name{path};
+
+        if (_command == Command::Compress)
+        {
+            name += extension;
+        }
+        else if (name.size() > extension.size() &&
+                 _tcsicmp(name.data() + name.size() - extension.size(), extension.data()) == 0)
+        {
+            name.resize(name.size() - extension.size());
+        }
+        else
+        {
+            name += _T(".out");
+        }
+
+        if (!_output.empty())
+        {
+            name = _output + _T("\\") + name.substr(name.find_last_of(_T("\\/")) + 1);
+        }
+
+        return name;
+    }
+
+    static uint64_t FileSize(const std::tstring& name)
+    {
+        LZOFile  file;
+        uint64_t size{};
+
+        return (file.OpenRead(name) && file.Size(size)) ? size : 0;
+    }
+
+    // Reads a list of one path per line (UTF-8, CR/LF or LF, empty lines are skipped)
+    std::vector<std::string> ReadList(LZOFile& input) const
+    {
+        std::vector<std::string> lines;
+        Bytes                    list;
+        size_t                   read{};
+
+        for (size_t size{};; size += read)
+        {
+            list.resize(size + BufferSize);
+
+            if (!input.Read(list.data() + size, BufferSize, read) || !read)
+            {
+                list.resize(size);
+                break;
+            }
+        }
+
+        for (size_t begin{}; begin < list.size();)
+        {
+            auto end{std::find(list.begin() + begin, list.end(), '\n') - list.begin()};
+            auto line{std::string(list.begin() + begin, list.begin() + end)};
+
+            begin = end + 1;
+
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            if (!line.empty())
+            {
+                lines.push_back(std::move(line));
+            }
+        }
+
+        return lines;
+    }
+
+    // Compresses the files of a list (_input or stdin, one path per line) into one archive: each file is a member of
+    // its own blocks and format (-f auto selects per file), the directory (FormatId Directory, an LZOArchiveEntry and
+    // the name per member) follows the blocks and is flagged in the trailer. Blocks of all members are compressed on
+    // _threads workers and written in list order.
+    int Archive()
+    {
+        struct Part
+        {
+            Bytes         Data;
+            size_t        Size{};
+            Bytes         Compressed;
+            size_t        CompressedSize{};
+            size_t        Member{};
+            LZOFormat::Id Format{};
+        };
+
+        if (_headerLess)
+        {
+            Message(_T("Archive needs a header"));
+
+            return Error(std::errc::invalid_argument);
+        }
+        if (!_block)
+        {
+            _block = DefaultBlockSize;
+        }
+        if (_block < MinimumBlockSize || _block > MaximumBlockSize)
+        {
+            Message(_T("Invalid block size"));
+
+            return Error(std::errc::invalid_argument);
+        }
+        if (_format == LZOFormat::Id::None && !_auto)
+        {
+            _format = LZOFormat::Id::Default;
+        }
+        if (!_auto && (!LZOFormat::FormatInfo(_format) || !LZOFormat::FormatInfo(_format)->FunctionCompress))
+        {
+            return Error(std::errc::not_supported);
+        }
+
+        LZOFile input;
+        LZOFile output;
+
+        if (!OpenInput(input) || !OpenOutput(output))
+        {
+            return _error;
+        }
+
+        try
+        {
+            const auto          list{ReadList(input)};
+            Statistics          statistics(Threads());
+            LZOHeader64         trailer;
+            LZOHeader64         member;
+            std::vector<Member> members(list.size());
+            std::vector<Bytes>  works(Threads());
+            size_t              current{SIZE_MAX};
+            LZOPipeline<Part>   pipeline(
+                works.size(),
+                [&](Part& part, const size_t worker) {
+                    part.CompressedSize =
+                        (part.Size) ? CompressBlock(part.Format, part.Data.data(), part.Size, part.Compressed,
+                                          works[worker], true)
+                                    : 0;
+
+                    return (part.CompressedSize || !part.Size) ? std::errc{} : std::errc::bad_address;
+                },
+                [&](Part& part) {
+                    auto& entry{members[part.Member].Entry};
+
+                    if (part.Member != current)
+                    {
+                        current      = part.Member;
+                        member       = {};
+                        entry.Offset = trailer.SourceSize;
+                    }
+                    if (!part.CompressedSize)
+                    {
+                        return std::errc{};
+                    }
+                    if (!output.Write(part.Compressed.data(), part.CompressedSize))
+                    {
+                        Message(_T("Error writing output"));
+
+                        return std::errc::bad_address;
+                    }
+
+                    WithHeader(part.Compressed.data(), [&](const auto* header) {
+                        statistics.Add(part.CompressedSize, part.Size, header->FormatId == LZOFormat::Id::None);
+                        trailer.Append(header);
+                        member.Append(header);
+                    });
+                    entry.SourceSize      = member.SourceSize;
+                    entry.DestinationSize = member.DestinationSize;
+                    entry.SourceHash      = member.SourceHash;
+                    entry.DestinationHash = member.DestinationHash;
+
+                    return std::errc{};
+                });
+
+            for (size_t index{}; index < list.size(); ++index)
+            {
+                const std::tstring path{CA2T(list[index].data(), CP_UTF8)};
+                LZOFile            file;
+                size_t             read{};
+
+                if (!file.OpenRead(path))
+                {
+                    Message(_T("Error opening "), path.data());
+                    pipeline.Finish();
+
+                    return Error(std::errc::no_such_file_or_directory);
+                }
+                if (_auto)
+                {
+                    SelectFormat(Sample(file));
+                }
+
+                members[index].Name           = list[index];
+                members[index].Entry.FormatId = _format;
+                members[index].Entry.NameSize = (uint32_t)list[index].size();
+
+                // Every member pushes at least one part (empty for an empty file), so its offset is recorded
+                do
+                {
+                    auto part{pipeline.Acquire()};
+
+                    part.Data.resize(_block);
+                    part.Member = index;
+                    part.Format = _format;
+
+                    if (!file.Read(part.Data.data(), part.Data.size(), part.Size))
+                    {
+                        Message(_T("Error reading "), path.data());
+                        pipeline.Finish();
+
+                        return Error(std::errc::io_error);
+                    }
+
+                    read = part.Size;
+
+                    if (pipeline.Push(std::move(part)) != std::errc{})
+                    {
+                        return Error(pipeline.Finish());
+                    }
+                } while (read == _block);
+            }
+
+            const auto error{pipeline.Finish()};
+
+            if (error != std::errc{})
+            {
+                return Error(error);
+            }
+
+            Bytes directory;
+
+            for (const auto& entry : members)
+            {
+                const auto data{(const byte*)&entry.Entry};
+
+                directory.insert(directory.end(), data, data + sizeof(LZOArchiveEntry));
+                directory.insert(directory.end(), entry.Name.begin(), entry.Name.end());
+            }
+
+            const auto directoryHash{LZOHash::Hash(_checksum, directory.data(), directory.size())};
+            Bytes      record(LZOHeader64::Size(directory.size()));
+            const auto header{(LZOHeader64*)record.data()};
+
+            memcpy_s(header->Data(), directory.size(), directory.data(), directory.size());
+            header->Initialize(LZOFormat::Id::Directory, directory.size(), directory.size(), directoryHash,
+                directoryHash, 0, _checksum);
+            trailer.Initialize(LZOFormat::Id::Stream, trailer.SourceSize, trailer.DestinationSize, trailer.SourceHash,
+                trailer.DestinationHash,
+                LZOHeader64::FlagDirectory | ((_optimize) ? LZOHeader64::FlagOptimized : 0), _checksum);
+
+            if (!output.Write(record.data(), record.size()) || !output.Write(&trailer, LZOHeader64::Size()) ||
+                !output.Flush())
+            {
+                Message(_T("Error writing output"));
+
+                return Error(std::errc::bad_address);
+            }
+            if (_verbose)
+            {
+                statistics.Print(_T("Archived"));
+            }
+
+            return Error({});
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    // Builds a preset dictionary (-o) from the sample files of a list (_input or stdin, one path per line)
+    int BuildDictionary()
+    {
+        LZOFile input;
+
+        if (!OpenInput(input))
+        {
+            return _error;
+        }
+
+        try
+        {
+            const auto          list{ReadList(input)};
+            Bytes               corpus;
+            std::vector<size_t> sizes;
+
+            for (const auto& line : list)
+            {
+                const std::tstring path{CA2T(line.data(), CP_UTF8)};
+                LZOFile            file;
+                uint64_t           size{};
+                size_t             read{};
+
+                if (!file.OpenRead(path) || !file.Size(size) || size > SIZE_MAX - corpus.size())
+                {
+                    Message(_T("Error opening "), path.data());
+
+                    return Error(std::errc::no_such_file_or_directory);
+                }
+
+                const auto offset{corpus.size()};
+
+                corpus.resize(offset + (size_t)size);
+
+                if (!file.Read(corpus.data() + offset, (size_t)size, read))
+                {
+                    Message(_T("Error reading "), path.data());
+
+                    return Error(std::errc::io_error);
+                }
+
+                corpus.resize(offset + read);
+                sizes.push_back(read);
+            }
+
+            if (corpus.empty())
+            {
+                Message(_T("No samples"));
+
+                return Error(std::errc::invalid_argument);
+            }
+
+            const auto dictionary{
+                LZODictionary::Build(corpus.data(), corpus.size(), sizes, LZODictionary::MaximumSize)};
+
+            if (_verbose)
+            {
+                std::tcerr << _T("Dictionary ") << dictionary.size() << _T(" bytes from ") << sizes.size()
+                           << _T(" sample(s) of ") << corpus.size() << _T(" bytes, id")
+                           << Hex(LZODictionary::Identify(dictionary.data(), dictionary.size())).data() << std::endl;
+            }
+
+            return Output(Bytes(dictionary.begin(), dictionary.end()));
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    // Lists the members of an archive from its directory (the blocks are not read)
+    int List()
+    {
+        LZOFile input;
+
+        if (!OpenInput(input))
+        {
+            return _error;
+        }
+        if (!input.Seekable())
+        {
+            Message(_T("Listing needs an input file"));
+
+            return Error(std::errc::invalid_argument);
+        }
+
+        try
+        {
+            std::vector<Member> members;
+            const auto          error{ReadDirectory(input, members)};
+            std::stringstream   stream;
+            uint64_t            sourceSize{};
+            uint64_t            destinationSize{};
+
+            if (error != std::errc{})
+            {
+                return Error(error);
+            }
+
+            stream << " Offset                 Compressed            Size Hash        Format      Name" << std::endl;
+
+            for (const auto& member : members)
+            {
+                const auto info{LZOFormat::FormatInfo(member.Entry.FormatId)};
+
+                stream << std::left << std::setw(18) << Hex64(member.Entry.Offset) << std::right << std::setw(16)
+                       << member.Entry.SourceSize << std::setw(16) << member.Entry.DestinationSize
+                       << Hex(member.Entry.DestinationHash) << "  " << std::left << std::setw(10)
+                       << ((info) ? info->Name : "Unknown") << "  " << member.Name << std::right << std::endl;
+                sourceSize += member.Entry.SourceSize;
+                destinationSize += member.Entry.DestinationSize;
+            }
+
+            stream << members.size() << " member(s), " << destinationSize << " bytes (" << sourceSize
+                   << " bytes compressed)" << std::endl;
+
+            return Output(stream.str());
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    // Measures compression/ decompression of the input (in blocks of _block) with all or the selected formats,
+    // the best time of _repeat iterations counts
+    int Bench()
+    {
+        if (_io)
+        {
+            return BenchIo();
+        }
+
+        const auto input{Input()};
+
+        if (input.empty())
+        {
+            return _error;
+        }
+        if (_hash)
+        {
+            return BenchHash(input);
+        }
+        if (!_block)
+        {
+            _block = DefaultBlockSize;
+        }
+
+        try
+        {
+            const auto          blocks{(input.size() + _block - 1) / _block};
+            std::vector<Bytes>  compressed(blocks);
+            std::vector<size_t> compressedSizes(blocks);
+            Bytes               decompressed(input.size() + LZOFormat::AsmSlack);
+            Bytes               work;
+            std::stringstream   stream;
+            size_t              rows{};
+            const auto          decoder{(_decoderSelected) ? _decoder : LZOFormat::Decoder::Fast};
+
+            if (_export == Export::Csv)
+            {
+                stream << "Format,CompressMBs,DecompressMBs,Ratio,MemoryCompress,MemoryDecompress,Level,Optimized"
+                       << std::endl;
+            }
+            else if (_export == Export::Json)
+            {
+                stream << "[" << std::endl;
+            }
+            else
+            {
+                stream << "Format        Compress MB/s  Decompress MB/s    Ratio %  MemoryCompress  MemoryDecompress"
+                       << "  Level  Optimized" << std::endl;
+            }
+
+            // Formats with levels are measured once per level of --level (level 0: the default of the format), with
+            // --optimize formats with an optimizer once more with optimized blocks
+            struct Run
+            {
+                const LZOFormat::Info* Info{};
+                int                    Level{};
+                bool                   Optimize{};
+            };
+            std::vector<Run> runs;
+
+            for (const auto& format : LZOFormat::FormatIds())
+            {
+                const auto info{LZOFormat::FormatInfo(format.second)};
+
+                if (!info || !info->FunctionCompress || !info->Decompressor(decoder, true, LZOFormat::AsmSlack) ||
+                    (!_formats.empty() &&
+                        std::find(_formats.begin(), _formats.end(), format.second) == _formats.end()))
+                {
+                    continue;
+                }
+                for (const auto level :
+                    (info->FunctionCompressLevel && !_levels.empty()) ? _levels : std::vector<int>{0})
+                {
+                    runs.push_back({info, level, false});
+
+                    if (_optimize && info->FunctionOptimize)
+                    {
+                        runs.push_back({info, level, true});
+                    }
+                }
+            }
+
+            for (const auto& [info, level, optimize] : runs)
+            {
+                const auto decompress{info->Decompressor(decoder, true, LZOFormat::AsmSlack)};
+
+                if (work.size() < LZOCodec::WorkSize(info))
+                {
+                    work.resize(LZOCodec::WorkSize(info));
+                }
+
+                double compressTime{};
+                double decompressTime{};
+                size_t total{};
+                bool   valid{true};
+
+                for (uint32_t iteration{}; iteration < std::max<uint32_t>(1, _repeat) && valid; ++iteration)
+                {
+                    auto start{std::chrono::steady_clock::now()};
+
+                    total = 0;
+
+                    for (size_t block{}; block < blocks && valid; ++block)
+                    {
+                        const auto size{std::min<size_t>(_block, input.size() - block * _block)};
+                        lzo_uint   compressedSize{LZOCodec::CompressedSize(size)};
+
+                        if (compressed[block].size() < compressedSize)
+                        {
+                            compressed[block].resize(compressedSize);
+                        }
+
+                        if (level)
+                        {
+                            valid = info->FunctionCompressLevel(input.data() + block * _block, size,
+                                        compressed[block].data(), &compressedSize, work.data(), nullptr, 0, nullptr,
+                                        level) == LZO_E_OK;
+                        }
+                        else
+                        {
+                            valid = info->FunctionCompress(input.data() + block * _block, size,
+                                        compressed[block].data(), &compressedSize, work.data()) == LZO_E_OK;
+                        }
+                        if (optimize && valid)
+                        {
+                            lzo_uint optimizedSize{size};
+
+                            valid = info->FunctionOptimize(compressed[block].data(), compressedSize,
+                                        decompressed.data() + block * _block, &optimizedSize,
+                                        work.data()) == LZO_E_OK &&
+                                    optimizedSize == size;
+                        }
+                        compressedSizes[block] = compressedSize;
+                        total += compressedSize;
+                    }
+
+                    const auto compressTimeIteration{Seconds(start)};
+
+                    start = std::chrono::steady_clock::now();
+
+                    for (size_t block{}; block < blocks && valid; ++block)
+                    {
+                        const auto size{std::min<size_t>(_block, input.size() - block * _block)};
+                        lzo_uint   decompressedSize{size};
+
+                        valid = decompress(compressed[block].data(), compressedSizes[block],
+                                    decompressed.data() + block * _block, &decompressedSize, work.data()) == LZO_E_OK &&
+                                decompressedSize == size;
+                    }
+
+                    const auto decompressTimeIteration{Seconds(start)};
+
+                    compressTime   = (iteration) ? std::min<double>(compressTime, compressTimeIteration)
+                                                 : compressTimeIteration;
+                    decompressTime = (iteration) ? std::min<double>(decompressTime, decompressTimeIteration)
+                                                 : decompressTimeIteration;
+                    valid          = valid && memcmp(input.data(), decompressed.data(), input.size()) == 0;
+                }
+
+                const auto megabytes{input.size() / (1024.0 * 1024.0)};
+                const auto compressSpeed{(valid && compressTime > 0) ? megabytes / compressTime : 0};
+                const auto decompressSpeed{(valid && decompressTime > 0) ? megabytes / decompressTime : 0};
+                const auto ratio{(valid) ? 100.0 * total / input.size() : 0};
+
+                stream << std::fixed << std::setprecision(2);
+
+                if (_export == Export::Csv)
+                {
+                    stream << info->Name << "," << compressSpeed << "," << decompressSpeed << "," << ratio << ","
+                           << info->MemoryCompress << "," << info->MemoryDecompress << "," << level << ","
+                           << optimize << std::endl;
+                }
+                else if (_export == Export::Json)
+                {
+                    stream << ((rows) ? ",\n" : "") << "{\"Format\":\"" << info->Name
+                           << "\",\"CompressMBs\":" << compressSpeed << ",\"DecompressMBs\":" << decompressSpeed
+                           << ",\"Ratio\":" << ratio << ",\"MemoryCompress\":" << info->MemoryCompress
+                           << ",\"MemoryDecompress\":" << info->MemoryDecompress << ",\"Level\":" << level
+                           << ",\"Optimized\":" << ((optimize) ? "true" : "false") << "}";
+                }
+                else
+                {
+                    stream << std::left << std::setw(12) << info->Name << std::right << std::setw(15)
+                           << compressSpeed << std::setw(17) << decompressSpeed << std::setw(11) << ratio
+                           << std::setw(16) << info->MemoryCompress << std::setw(18) << info->MemoryDecompress
+                           << std::setw(7) << level << std::setw(11) << ((optimize) ? "yes" : "no")
+                           << ((valid) ? "" : " (error)") << std::endl;
+                }
+
+                ++rows;
+            }
+
+            if (_export == Export::Json)
+            {
+                stream << std::endl << "]" << std::endl;
+            }
+
+            return Output(stream.str());
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    // Measures the checksum kernels supported by the CPU over the input, the best time of _repeat iterations counts
+    int BenchHash(const Bytes& input)
+    {
+        std::stringstream stream;
+        size_t            rows{};
+
+        if (_export == Export::Csv)
+        {
+            stream << "Hash,MBs" << std::endl;
+        }
+        else if (_export == Export::Json)
+        {
+            stream << "[" << std::endl;
+        }
+        else
+        {
+            stream << "Hash                  MB/s" << std::endl;
+        }
+
+        for (const auto& kernel : LZOHash::Kernels())
+        {
+            if (!kernel.Supported)
+            {
+                continue;
+            }
+
+            // The first kernel of a checksum is the scalar reference
+            const auto reference{std::find_if(LZOHash::Kernels().begin(), LZOHash::Kernels().end(),
+                [&](const auto& other) { return other.Type == kernel.Type; })};
+            const auto expected{reference->Hash(0, input.data(), input.size())};
+            double     time{};
+            bool       valid{true};
+
+            for (uint32_t iteration{}; iteration < std::max<uint32_t>(1, _repeat); ++iteration)
+            {
+                const auto start{std::chrono::steady_clock::now()};
+
+                valid = kernel.Hash(0, input.data(), input.size()) == expected && valid;
+
+                const auto timeIteration{Seconds(start)};
+
+                time = (iteration) ? std::min<double>(time, timeIteration) : timeIteration;
+            }
+
+            const auto speed{(valid && time > 0) ? input.size() / (1024.0 * 1024.0) / time : 0};
+
+            stream << std::fixed << std::setprecision(2);
+
+            if (_export == Export::Csv)
+            {
+                stream << kernel.Name << "," << speed << std::endl;
+            }
+            else if (_export == Export::Json)
+            {
+                stream << ((rows) ? ",\n" : "") << "{\"Hash\":\"" << kernel.Name << "\",\"MBs\":" << speed << "}";
+            }
+            else
+            {
+                stream << std::left << std::setw(18) << kernel.Name << std::right << std::setw(8) << speed
+                       << ((valid) ? "" : " (error)") << std::endl;
+            }
+
+            ++rows;
+        }
+
+        if (_export == Export::Json)
+        {
+            stream << std::endl << "]" << std::endl;
+        }
+
+        return Output(stream.str());
+    }
+
+    // Measures reading the input file in blocks of _block synchronously and with overlapped reads in flight (the depth
+    // of --async or 2...32), with --direct unbuffered too. The best time of _repeat iterations counts, the growth of
+    // the system file cache over the iterations is the cache footprint.
+    int BenchIo()
+    {
+        if (_input.empty())
+        {
+            Message(_T("Benchmark of I/O needs an input file"));
+
+            return Error(std::errc::invalid_argument);
+        }
+        if (!_block)
+        {
+            _block = DefaultBlockSize;
+        }
+
+        try
+        {
+            struct Run
+            {
+                uint32_t Depth{};
+                bool     Direct{};
+            };
+            const auto        depths{(_async) ? std::vector<uint32_t>{0, _async}
+                                              : std::vector<uint32_t>{0, 2, 4, 8, 16, 32}};
+            std::vector<Run>  runs;
+            Bytes             block(_block);
+            std::stringstream stream;
+            size_t            rows{};
+
+            for (const auto direct : {false, true})
+            {
+                for (const auto depth : depths)
+                {
+                    // Direct reads go through the queue, at least one request is in flight
+                    const Run run{(direct) ? std::max<uint32_t>(1, depth) : depth, direct};
+
+                    if ((!direct || _direct) &&
+                        (runs.empty() || runs.back().Depth != run.Depth || runs.back().Direct != run.Direct))
+                    {
+                        runs.push_back(run);
+                    }
+                }
+            }
+
+            if (_export == Export::Csv)
+            {
+                stream << "Io,Depth,MBs,CacheMB" << std::endl;
+            }
+            else if (_export == Export::Json)
+            {
+                stream << "[" << std::endl;
+            }
+            else
+            {
+                stream << "I/O           Depth      MB/s  Cache MB" << std::endl;
+            }
+
+            for (const auto& [depth, direct] : runs)
+            {
+                const auto cache{LZOFile::CacheSize()};
+                auto       name{(direct) ? "direct" : (depth) ? "overlapped" : "blocking"};
+                uint64_t   total{};
+                double     time{};
+                bool       valid{true};
+
+                for (uint32_t iteration{}; iteration < std::max<uint32_t>(1, _repeat) && valid; ++iteration)
+                {
+                    LZOFile  file;
+                    uint64_t size{};
+                    size_t   read{};
+
+                    // Opening (and allocating the requests) is not measured
+                    total = 0;
+                    valid = OpenInput(file, depth, direct) && file.Size(size);
+
+                    if (direct && !file.Direct())
+                    {
+                        name = "sequential";
+                    }
+
+                    const auto start{std::chrono::steady_clock::now()};
+
+                    while (valid && file.Read(block.data(), block.size(), read) && read)
+                    {
+                        total += read;
+                    }
+
+                    const auto timeIteration{Seconds(start)};
+
+                    valid = valid && total == size;
+                    time  = (iteration) ? std::min<double>(time, timeIteration) : timeIteration;
+                }
+
+                const auto speed{(valid && time > 0) ? total / (1024.0 * 1024.0) / time : 0};
+                const auto cacheGrowth{((int64_t)LZOFile::CacheSize() - (int64_t)cache) / (1024.0 * 1024.0)};
+
+                stream << std::fixed << std::setprecision(2);
+
+                if (_export == Export::Csv)
+                {
+                    stream << name << "," << depth << "," << speed << "," << cacheGrowth << std::endl;
+                }
+                else if (_export == Export::Json)
+                {
+                    stream << ((rows) ? ",\n" : "") << "{\"Io\":\"" << name << "\",\"Depth\":" << depth
+                           << ",\"MBs\":" << speed << ",\"CacheMB\":" << cacheGrowth << "}";
+                }
+                else
+                {
+                    stream << std::left << std::setw(12) << name << std::right << std::setw(7) << depth
+                           << std::setw(10) << speed << std::setw(10) << cacheGrowth << ((valid) ? "" : " (error)")
+                           << std::endl;
+                }
+
+                ++rows;
+            }
+
+            if (_export == Export::Json)
+            {
+                stream << std::endl << "]" << std::endl;
+            }
+
+            return Output(stream.str());
+        }
+        catch (std::exception&)
+        {
+            return Error(std::errc::not_enough_memory);
+        }
+    }
+
+    static double Seconds(const std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    int Help()
+    {
+        std::tstringstream stream;
+
+        stream << _T(R"(Usage: LZOStream <command> [<option>...] [> output] [< input]
+
+<Commands>
+    c|compress              Compress    (-i -o -f -h -l -b -t -v -m -x -p -k -w --batch --dict --level --optimize
+                                         --async --direct)
+    d|decompress            Decompress  (-i -o -f -h -b -t -v -m -p -w --batch --dict --decoder --async --direct
+                                         --sparse)
+    i|info                  Info        (-i -o)
+    x|extract               Extract     (-i -o -s -n --member --dict --decoder --sparse)
+    b|bench                 Benchmark   (-i -o -f -b -r -e -a --level --optimize --decoder --io --async --direct)
+    a|archive               Archive     (-i -o -f -l -b -t -v -p -k --dict --level --optimize)
+    l|list                  List        (-i -o)
+    y|dictionary            Dictionary  (-i -o -v)
+    t|test                  Test        (-i -o -t --batch --dict --decoder --async --direct)
+
+<Options> 
+    -i|--input <file>       Input file
+    -o|--output <file>      Output file
+    -f|--format <method>    Compression method (compress/ decompress headerless, bench: list e.g. Lzo1x_1,Lzo2a)
+                            auto (compress: selected by samples of the input)
+    --target-speed <MB/s>   Best ratio with at least this compression speed (compress: -f auto, default 50)
+    --target-ratio <%>      Fastest with at most this compressed size in percent (compress: -f auto)
+    -h|--headerless         Headerless output (compress)
+    -l|--limitless          No limitation (compress: data maybe larger)
+    -b|--block <size>       Block size (compress: 256k...64m blocks, decompress: headerless)
+    -t|--threads <count>    Threads (compress/ decompress: blocks, 0 = all cores, at most 64)
+    -v|--verbose            Statistics (sizes, time and throughput to stderr)
+    -m|--mapped             Memory mapped input/ output files (compress: input, decompress: output)
+    -w|--stream             Read, compress/ decompress and write blocks overlapped on separate threads
+    --async <depth>         Overlapped file I/O with up to depth requests of 1 MB in flight (compress/ decompress/
+                            test: 1...64, bench: with --io)
+    --direct                Unbuffered file I/O bypassing the file cache, else sequential scan (compress/ decompress/
+                            test, bench: with --io)
+    --sparse                Zero pieces of 64 KB left as holes of a sparse output file (decompress/ extract)
+    --batch                 Input is a list of files (one per line) each written to its own output (-o: directory,
+                            test: files verified concurrently)
+    -x|--index              Block index before the trailer (compress: blocks)
+    -k|--checksum <type>    Checksum of the hashes adler32, crc32c, xxh64 or none (compress: default adler32)
+    --dict <file>           Preset dictionary (compress: Lzo1x, Lzo1y or Lzo1z, decompress: blocks with dictionary)
+    --level <1-9>           Level of Lzo1x_999, Lzo1y_999 or Lzo1z_999: 1 fastest, 9 best ratio (compress: default 8,
+                            bench: list e.g. 1,5,9 measured per format with levels)
+    --decoder <type>        Decompressor safe, fast or asm (decompress: default safe for stdin, fast for files)
+    --optimize              Optimized blocks for faster decompression (compress: Lzo1x, Lzo1y, bench: measured too)
+    -p|--large-pages        Large pages for buffers (needs the privilege to lock pages in memory)
+    -s|--offset <offset>    Offset in the decompressed data (extract)
+    -n|--length <length>    Length of the decompressed data (extract: 0 = up to the end)
+    --member <name>         Member of an archive (extract: name as listed)
+    -r|--repeat <count>     Iterations (bench: best time counts, default 3)
+    -e|--export <csv|json>  Export format (bench: default table)
+    -a|--hash               Checksum kernels instead of methods (bench)
+    --io                    Reading the input blocking and overlapped instead of methods (bench: -i file)
+
+<Methods>
+    Lzo1,  Lzo1_99
+    Lzo1a, Lzo1a_99
+    Lzo1b, Lzo1b_1 ... Lzo1b_9, Lzo1b_99, Lzo1b_999
+    Lzo1c, Lzo1c_1 ... Lzo1c_9, Lzo1c_99, Lzo1c_999
+    Lzo1f, Lzo1f_1, Lzo1f_999
+    Lzo1x, Lzo1x_1, Lzo1x_1_11, Lzo1x_1_12, Lzo1x_1_15, Lzo1x_999
+    Lzo1y, Lzo1y_1, Lzo1y_999
+    Lzo1z, Lzo1z_999
+    Lzo2a, Lzo2a_999
+)");
+        Message(stream.str().data());
+
+        return Error({});
+    }
+
+    int Parse(const std::vector<LPCTSTR>& arguments)
+    {
+        Option option{};
+
+        for (const auto& argument : arguments)
+        {
+            if (option == Option::Input)
+            {
+                _input = argument;
+                option = {};
+            }
+            else if (option == Option::Output)
+            {
+                _output = argument;
+                option  = {};
+            }
+            else if (option == Option::Format && Equals(argument, {_T("auto")}))
+            {
+                _auto   = true;
+                _format = LZOFormat::Id::None;
+                option  = {};
+            }
+            else if (option == Option::Format)
+            {
+                std::tstringstream formats(argument);
+                std::tstring       format;
+
+                _auto = false;
+                _formats.clear();
+
+                while (std::getline(formats, format, _T(',')))
+                {
+                    _formats.push_back(LZOFormat::FormatId(format.data()));
+
+                    if (_formats.back() == LZOFormat::Id::None)
+                    {
+                        Message(_T("Unknown format"), format.data());
+
+                        return Error(std::errc::invalid_argument);
+                    }
+                }
+                if (_formats.empty())
+                {
+                    Message(_T("Unknown format"), argument);
+
+                    return Error(std::errc::invalid_argument);
+                }
+
+                _format = _formats.front();
+                option  = {};
+            }
+            else if (option == Option::TargetSpeed || option == Option::TargetRatio)
+            {
+                if (argument && isdigit((byte)*argument))
+                {
+                    if (option == Option::TargetSpeed)
+                    {
+                        _targetSpeed = _tstol(argument);
+                    }
+                    else
+                    {
+                        _targetRatio = _tstol(argument);
+                    }
+                }
+                else
+                {
+                    Message(_T("Unknown target"), argument);
+
+                    return Error(std::errc::invalid_argument);
+                }
+                option = {};
+            }
+            else if (option == Option::Repeat)
+            {
+                if (argument && isdigit((byte)*argument))
+                {
+                    _repeat = _tstol(argument);
+                }
+                else
+                {
+                    Message(_T("Unknown count"), argument);
+
+                    return Error(std::errc::invalid_argument);
+                }
+                option = {};
+            }
+            else if (option == Option::Export)
+            {
+                if (Equals(argument, {_T("csv")}))
+                {
+                    _export = Export::Csv;
+                }
+                else if (Equals(argument, {_T("json")}))
+                {
+                    _export = Export::Json;
+                }
+                else
+                {
+                    Message(_T("Unknown export"), argument);
+
+                    return Error(std::errc::invalid_argument);
+                }
+                option = {};
+            }
+            else if (option == Option::Decoder)
+            {
+                if (Equals(argument, {_T("safe")}))
+                {
+                    _decoder = LZOFormat::Decoder::Safe;
+                }
+                else if (Equals(argument, {_T("fast")}))
+                {
+                    _decoder = LZOFormat::Decoder::Fast;
+                }
+                else if (Equals(argument, {_T("asm")}))
+                {
+                    _decoder = LZOFormat::Decoder::Asm;
+                }
+                else
+                {
+                    Message(_T("Unknown decoder"), argument);
+
+                    return Error(std::errc::invalid_argument);
+                }
+                _decoderSelected = true;
+                option           = {};
+            }
+            else if (option == Option::Checksum)
+            {
+                if (Equals(argument, {_T("adler32")}))
+                {
+                    _checksum = LZOHash::Checksum::Adler32;
+                }
+                else if (Equals(argument, {_T("crc32c")}))
+                {
+                    _checksum = LZOHash::Checksum::Crc32c;
+                }
+                else if (Equals(argument, {_T("xxh64")}))
+                {
+                    _checksum = LZOHash::Checksum::Xxh64;
+                }
+                else if (Equals(argument, {_T("none")}))
+                {
+                    _checksum = LZOHash::Checksum::None;
+                }
+                else
+                {
+                    Message(_T("Unknown checksum"), argument);
+
+                    return Error(std::errc::invalid_argument);
+                }
+                option = {};
+            }
+            else if (option == Option::Block)
+            {
+                if (argument && isdigit((byte)*argument))
+                {
+                    _block = (uint32_t)std::min<uint64_t>(Size(argument), MAXDWORD);
+                }
+                else
+                {
+                    Message(_T("Unknown size"), argument);
+
+                    return Error(std::errc::invalid_argument);
+                }
+                option = {};
+            }
+            else if (option == Option::Threads)
+            {
+                if (argument && isdigit((byte)*argument))
+                {
+                    _threads = _tstol(argument);
 
-        return Output(stream.str());
-    }
+                    if (!_threads)
+                    {
+                        _threads = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+                    }
 
-    int Help()
-    {
-        std::tstringstream stream;
+                    // Each thread keeps up to two blocks in flight, the address space of a process is limited
+                    _threads = std::min<uint32_t>(_threads, MaximumThreads);
+                }
+                else
+                {
+                    Message(_T("Unknown count"), argument);
 
-        stream << _T(R"(Usage: LZOStream <command> [<option>...] [> output] [< input]
+                    return Error(std::errc::invalid_argument);
+                }
+                option = {};
+            }
+            else if (option == Option::Member)
+            {
+                _member = argument;
+                option  = {};
+            }
+            else if (option == Option::Dictionary)
+            {
+                _dictionaryFile = argument;
+                option          = {};
+            }
+            else if (option == Option::Level)
+            {
+                std::tstringstream levels(argument);
+                std::tstring       level;
 
-<Commands>
-    c|compress              Compress    (-i -o -f -h -l)
-    d|decompress            Decompress  (-i -o -f -h -b)
-    i|info                  Info        (-i -o)
+                _levels.clear();
 
-<Options> 
-    -i|--input <file>       Input file
-    -o|--output <file>      Output file
-    -f|--format <method>    Compression method (compress/ decompress headerless)
-    -h|--headerless         Headerless output (compress)
-    -l|--limitless          No limitation (compress: data maybe larger)
-    -b|--block <size>       Block size (decompress: headerless)
+                while (std::getline(levels, level, _T(',')))
+                {
+                    _levels.push_back((isdigit((byte)level[0]) && level.size() == 1) ? level[0] - _T('0') : 0);
 
-<Methods>
-    Lzo1,  Lzo1_99
-    Lzo1a, Lzo1a_99
-    Lzo1b, Lzo1b_1 ... Lzo1b_9, Lzo1b_99, Lzo1b_999
-    Lzo1c, Lzo1c_1 ... Lzo1c_9, Lzo1c_99, Lzo1c_999
-    Lzo1f, Lzo1f_1, Lzo1f_999
-    Lzo1x, Lzo1x_1, Lzo1x_1_11, Lzo1x_1_12, Lzo1x_1_15, Lzo1x_999
-    Lzo1y, Lzo1y_1, Lzo1y_999
-    Lzo1z, Lzo1z_999
-    Lzo2a, Lzo2a_999
-)");
-        Message(stream.str().data());
+                    if (_levels.back() < 1 || _levels.back() > 9)
+                    {
+                        Message(_T("Unknown level"), level.data());
 
-        return Error({});
-    }
+                        return Error(std::errc::invalid_argument);
+                    }
+                }
+                if (_levels.empty())
+                {
+                    Message(_T("Unknown level"), argument);
 
-    int Parse(const std::vector<LPCTSTR>& arguments)
-    {
-        Option option{};
+                    return Error(std::errc::invalid_argument);
+                }
 
-        for (const auto& argument : arguments)
-        {
-            if (option == Option::Input)
-            {
-                _input = argument;
+                _level = _levels.front();
                 option = {};
             }
-            else if (option == Option::Output)
-            {
-                _output = argument;
-                option  = {};
-            }
-            else if (option == Option::Format)
+            else if (option == Option::Async)
             {
-                _format = LZOFormat::FormatId(argument);
+                _async = (argument && isdigit((byte)*argument)) ? (uint32_t)_tstol(argument) : 0;
 
-                if (_format == LZOFormat::Id::None)
+                if (!_async || _async > MaximumDepth)
                 {
-                    Message(_T("Unknown format"), argument);
+                    Message(_T("Unknown depth"), argument);
 
                     return Error(std::errc::invalid_argument);
                 }
                 option = {};
             }
-            else if (option == Option::Block)
+            else if (option == Option::Offset || option == Option::Length)
             {
                 if (argument && isdigit((byte)*argument))
                 {
-                    _block = _tstol(argument);
+                    if (option == Option::Offset)
+                    {
+                        _offset = Size(argument);
+                    }
+                    else
+                    {
+                        _length = Size(argument);
+                    }
                 }
                 else
                 {
@@ -441,6 +3113,30 @@ public:
             {
                 _command = Command::Info;
             }
+            else if (Equals(argument, {_T("x"), _T("extract")}))
+            {
+                _command = Command::Extract;
+            }
+            else if (Equals(argument, {_T("b"), _T("bench")}))
+            {
+                _command = Command::Bench;
+            }
+            else if (Equals(argument, {_T("a"), _T("archive")}))
+            {
+                _command = Command::Archive;
+            }
+            else if (Equals(argument, {_T("l"), _T("list")}))
+            {
+                _command = Command::List;
+            }
+            else if (Equals(argument, {_T("y"), _T("dictionary")}))
+            {
+                _command = Command::Dictionary;
+            }
+            else if (Equals(argument, {_T("t"), _T("test")}))
+            {
+                _command = Command::Test;
+            }
             else if (Equals(argument, {_T("-i"), _T("--input")}))
             {
                 option = Option::Input;
@@ -457,6 +3153,58 @@ public:
             {
                 option = Option::Block;
             }
+            else if (Equals(argument, {_T("-t"), _T("--threads")}))
+            {
+                option = Option::Threads;
+            }
+            else if (Equals(argument, {_T("--target-speed")}))
+            {
+                option = Option::TargetSpeed;
+            }
+            else if (Equals(argument, {_T("--target-ratio")}))
+            {
+                option = Option::TargetRatio;
+            }
+            else if (Equals(argument, {_T("-r"), _T("--repeat")}))
+            {
+                option = Option::Repeat;
+            }
+            else if (Equals(argument, {_T("-e"), _T("--export")}))
+            {
+                option = Option::Export;
+            }
+            else if (Equals(argument, {_T("-k"), _T("--checksum")}))
+            {
+                option = Option::Checksum;
+            }
+            else if (Equals(argument, {_T("-s"), _T("--offset")}))
+            {
+                option = Option::Offset;
+            }
+            else if (Equals(argument, {_T("-n"), _T("--length")}))
+            {
+                option = Option::Length;
+            }
+            else if (Equals(argument, {_T("--member")}))
+            {
+                option = Option::Member;
+            }
+            else if (Equals(argument, {_T("--dict")}))
+            {
+                option = Option::Dictionary;
+            }
+            else if (Equals(argument, {_T("--level")}))
+            {
+                option = Option::Level;
+            }
+            else if (Equals(argument, {_T("--decoder")}))
+            {
+                option = Option::Decoder;
+            }
+            else if (Equals(argument, {_T("--async")}))
+            {
+                option = Option::Async;
+            }
             else if (Equals(argument, {_T("-h"), _T("--headerless")}))
             {
                 _headerLess = true;
@@ -465,6 +3213,50 @@ public:
             {
                 _limitLess = true;
             }
+            else if (Equals(argument, {_T("-x"), _T("--index")}))
+            {
+                _index = true;
+            }
+            else if (Equals(argument, {_T("-a"), _T("--hash")}))
+            {
+                _hash = true;
+            }
+            else if (Equals(argument, {_T("--io")}))
+            {
+                _io = true;
+            }
+            else if (Equals(argument, {_T("--direct")}))
+            {
+                _direct = true;
+            }
+            else if (Equals(argument, {_T("--sparse")}))
+            {
+                _sparse = true;
+            }
+            else if (Equals(argument, {_T("-p"), _T("--large-pages")}))
+            {
+                _largePages = true;
+            }
+            else if (Equals(argument, {_T("--batch")}))
+            {
+                _batch = true;
+            }
+            else if (Equals(argument, {_T("--optimize")}))
+            {
+                _optimize = true;
+            }
+            else if (Equals(argument, {_T("-w"), _T("--stream")}))
+            {
+                _stream = true;
+            }
+            else if (Equals(argument, {_T("-m"), _T("--mapped")}))
+            {
+                _mapped = true;
+            }
+            else if (Equals(argument, {_T("-v"), _T("--verbose")}))
+            {
+                _verbose = true;
+            }
             else if (Equals(argument, {_T("-d"), _T("--debug")}))
             {
                 _debugger = true;
@@ -498,13 +3290,25 @@ public:
 
             try
             {
-                Bytes buffer(BufferSize);
-                DWORD read{};
+                size_t size{};
+                DWORD  read{};
 
-                while (ReadFile(handle, buffer.data(), (DWORD)buffer.size(), &read, nullptr) && read)
+                // Reads into the free end of bytes (growing geometrically) without copying a read buffer
+                for (;;)
                 {
-                    bytes.insert(bytes.end(), buffer.begin(), buffer.begin() + read);
+                    bytes.resize(std::max<size_t>(bytes.capacity(), size + BufferSize));
+
+                    const auto chunk{(DWORD)std::min<size_t>(bytes.size() - size, MAXDWORD)};
+
+                    if (!ReadFile(handle, bytes.data() + size, chunk, &read, nullptr) || !read)
+                    {
+                        break;
+                    }
+
+                    size += read;
                 }
+
+                bytes.resize(size);
             }
             catch (std::exception&)
             {
@@ -560,6 +3364,141 @@ public:
         return bytes;
     }
 
+    // Loads the preset dictionary of --dict
+    bool LoadDictionary()
+    {
+        LZOFile  file;
+        uint64_t size{};
+        size_t   read{};
+
+        if (!file.OpenRead(_dictionaryFile) || !file.Size(size))
+        {
+            Message(_T("Error opening "), _dictionaryFile.data());
+            Error(std::errc::no_such_file_or_directory);
+
+            return false;
+        }
+
+        try
+        {
+            _dictionary.resize((size_t)std::min<uint64_t>(size, LZODictionary::MaximumSize));
+
+            // A larger dictionary is used by its end (the window of the compressors)
+            if (!file.Seek(size - _dictionary.size()) || !file.Read(_dictionary.data(), _dictionary.size(), read) ||
+                read != _dictionary.size() || _dictionary.empty())
+            {
+                Message(_T("Error reading "), _dictionaryFile.data());
+                Error(std::errc::io_error);
+
+                return false;
+            }
+        }
+        catch (std::exception&)
+        {
+            Error(std::errc::not_enough_memory);
+
+            return false;
+        }
+
+        _dictionaryId = LZODictionary::Identify(_dictionary.data(), _dictionary.size());
+
+        return true;
+    }
+
+    // Preset dictionary of --dict (Size 0 without)
+    LZODictionary Dictionary() const
+    {
+        return {_dictionary.data(), _dictionary.size(), _dictionaryId};
+    }
+
+    // Decoder of --decoder, without it safe for stdin (untrusted input) and fast (after verification) for files
+    LZOFormat::Decoder Decoder() const
+    {
+        if (_decoderSelected)
+        {
+            return _decoder;
+        }
+
+        return (_input.empty()) ? LZOFormat::Decoder::Safe : LZOFormat::Decoder::Fast;
+    }
+
+    // Size of the input (-i or stdin redirected from a file), UINT64_MAX if unknown (a pipe or console)
+    uint64_t InputSize() const
+    {
+        LZOFile  file;
+        uint64_t size{};
+
+        return (file.OpenRead(_input) && file.Seekable() && file.Size(size)) ? size : UINT64_MAX;
+    }
+
+    // Opens -i, depth overlapped reads in flight for a file (--async), direct unbuffered (--direct)
+    bool OpenInput(LZOFile& file, const uint32_t depth = 0, const bool direct = false)
+    {
+        if (file.OpenRead(_input, depth, direct))
+        {
+            return true;
+        }
+
+        if (_input.empty())
+        {
+            Message(_T("Error reading input"));
+            Error(std::errc::no_such_device);
+        }
+        else
+        {
+            Message(_T("Error opening "), _input.data());
+            Error(std::errc::no_such_file_or_directory);
+        }
+
+        return false;
+    }
+
+    // Opens -o, depth overlapped writes in flight for a file (--async), direct unbuffered (--direct), the output has to
+    // be flushed
+    bool OpenOutput(LZOFile& file, const bool mappable = false, const uint32_t depth = 0, const bool direct = false)
+    {
+        if (file.OpenWrite(_output, mappable, depth, direct))
+        {
+            return true;
+        }
+
+        if (_output.empty())
+        {
+            Message(_T("Error writing output"));
+            Error(std::errc::no_such_device);
+        }
+        else
+        {
+            Message(_T("Error creating "), _output.data());
+            Error(std::errc::no_such_file_or_directory);
+        }
+
+        return false;
+    }
+
+    // I/O of the files for the statistics: with --direct direct or the fallback sequential, with --sparse the bytes
+    // left as holes (empty without both)
+    std::tstring Access(const LZOFile& input, const LZOFile* output) const
+    {
+        std::tstringstream access;
+
+        if (_direct)
+        {
+            access << _T("input ") << ((input.Direct()) ? _T("direct") : _T("sequential"));
+
+            if (output)
+            {
+                access << _T(", output ") << ((output->Direct()) ? _T("direct") : _T("sequential"));
+            }
+        }
+        if (_sparse && output)
+        {
+            access << ((_direct) ? _T(", ") : _T("")) << output->Holes() << _T(" bytes sparse");
+        }
+
+        return access.str();
+    }
+
     int Output(const Bytes& bytes, const size_t offset = {})
     {
         if (_output.empty())
@@ -584,28 +3523,24 @@ public:
         }
         else
         {
-            HANDLE handle{
-                CreateFile(_output.data(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)};
+            LZOFile file;
 
-            if (handle == INVALID_HANDLE_VALUE)
+            if (!file.OpenWrite(_output))
             {
                 Message(_T("Error creating "), _output.data());
 
                 return Error(std::errc::no_such_file_or_directory);
             }
-
-            DWORD written{};
-
-            if (!WriteFile(handle, bytes.data() + offset, bytes.size() - offset, &written, nullptr))
+            if (_sparse)
+            {
+                file.Sparse();
+            }
+            if (!file.Write(bytes.data() + offset, bytes.size() - offset) || !file.Flush())
             {
-                CloseHandle(handle);
-
                 Message(_T("Error writing "), _output.data());
 
                 return Error(std::errc::bad_address);
             }
-
-            CloseHandle(handle);
         }
 
         return Error({});
@@ -646,20 +3581,58 @@ public:
         return false;
     }
 
-    static void Message(LPCTSTR message = {}, LPCTSTR argument = {})
+    // Writes the title and message (with argument) to stdout. A file of batch/ test collects its messages in
+    // _messages (without title), they are written in list order.
+    void Message(LPCTSTR message = {}, LPCTSTR argument = {}) const
     {
-        std::tcout << TitleVersion << std::endl << std::endl;
+        if (_messages && !message)
+        {
+            return;
+        }
+        if (!_messages)
+        {
+            std::tcout << TitleVersion << std::endl << std::endl;
+        }
+
+        auto& stream{(_messages) ? *_messages : std::tcout};
 
         if (message)
         {
-            std::tcout << message;
+            stream << message;
 
             if (argument)
             {
-                std::tcout << argument;
+                stream << argument;
             }
-            std::tcout << std::endl;
+            stream << std::endl;
+        }
+    }
+
+    size_t Threads() const
+    {
+        return std::max<uint32_t>(1, _threads);
+    }
+
+    // Parses a size with an optional k/ m/ g suffix (e.g. 256k, 4m)
+    static uint64_t Size(LPCTSTR argument)
+    {
+        LPTSTR end{};
+        auto   size{(uint64_t)_tcstoui64(argument, &end, 10)};
+
+        if (end && (*end == 'k' || *end == 'K'))
+        {
+            size *= 1024;
+        }
+        else if (end && (*end == 'm' || *end == 'M'))
+        {
+            size *= 1024 * 1024;
+        }
+        else if (end && (*end == 'g' || *end == 'G'))
+        {
+            size *= 1024 * 1024 * 1024;
         }
+
+        return size;
     }
 
     template <typename T>
@@ -667,7 +3640,20 @@ public:
     {
         std::stringstream stream;
 
-        stream << " 0x" << std::setfill('0') << std::setw(8) << std::hex << (uint32_t)value;
+        stream << " 0x" << std::setfill('0') << std::setw(sizeof(T) * 2) << std::hex << (uint64_t)value;
+
+        return stream.str();
+    }
+    // Hex with 8 digits up to 4 GB
+    static std::string Hex64(const uint64_t value)
+    {
+        return (value > MAXDWORD) ? Hex(value) : Hex((uint32_t)value);
+    }
+    static std::string Offset(const size_t offset)
+    {
+        std::stringstream stream;
+
+        stream << "[0x" << std::setfill('0') << std::setw(2) << std::hex << offset << "]";
 
         return stream.str();
     }
@@ -680,10 +3666,43 @@ private:
     Command       _command{};
     std::tstring  _input;
     std::tstring  _output;
+    std::tstring  _member;
+    std::tstring  _dictionaryFile;
+    Bytes         _dictionary;
+    uint32_t      _dictionaryId{};
+    int           _level{};
     LZOFormat::Id _format{LZOFormat::Id::None};
     bool          _headerLess{};
     bool          _limitLess{};
     bool          _debugger{};
+    bool          _verbose{};
+    bool          _mapped{};
+    bool          _index{};
+    bool          _largePages{};
+    bool          _stream{};
+    bool          _batch{};
+    bool          _optimize{};
     uint32_t      _block{};
+    uint32_t      _threads{};
+    uint64_t      _offset{};
+    uint64_t      _length{};
+    uint32_t      _repeat{3};
+    uint32_t      _targetSpeed{};
+    uint32_t      _targetRatio{};
+    bool          _auto{};
+    bool          _hash{};
+    bool          _io{};
+    uint32_t      _async{};
+    bool          _direct{};
+    bool          _sparse{};
+    Export        _export{};
     int           _error{};
+
+    LZOHash::Checksum  _checksum{LZOHash::Checksum::Adler32};
+    LZOFormat::Decoder _decoder{LZOFormat::Decoder::Fast};
+    bool               _decoderSelected{};
+
+    std::vector<LZOFormat::Id> _formats;
+    std::vector<int>           _levels;
+    std::tstringstream*        _messages{};
 };
@@ -0,0 +1,154 @@
+/* LZOStream\LZODictionary.h -- preset dictionaries
+
+   This file is part of the LZOStream application for compressing/ decompressing files or streams.
+
+   Copyright (C) 2024 G DATA CyberDefense AG
+   All Rights Reserved.
+
+   The LZOStream application is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZOStream application is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZOStream application; see the file License.txt.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   G DATA CyberDefense AG
+   <source@gdata.de>
+   https://www.gdata.de/
+*/
+
+#pragma once
+#include "LZOHash.h"
+#include <algorithm>
+#include <vector>
+
+// Preset dictionary of the LZO1X/ LZO1Y/ LZO1Z compressors: the window starts with the dictionary instead of being
+// empty, so small blocks can reference data that is common to all of them. Blocks record the Id of their dictionary
+// (Identify of the data).
+struct LZODictionary
+{
+    // Window of the compressors (M4_MAX_OFFSET), older dictionary data is never referenced
+    static constexpr size_t MaximumSize{0xbfff};
+
+    // Id of dictionary data (XXH64, never 0)
+    static uint32_t Identify(const byte* data, const size_t size)
+    {
+        const auto id{LZOHash::Hash(LZOHash::Checksum::Xxh64, data, size)};
+
+        return (id) ? id : 1;
+    }
+
+    // Builds a dictionary of at most size bytes from samples (sampleSizes split the corpus). Sequences of 8 bytes are
+    // counted once per sample, the corpus is split into epochs and of each epoch the segment of 256 bytes with the most
+    // frequent sequences is taken (its sequences no longer count). The segments are ordered by their score, the best
+    // at the end where the distance to the data is shortest.
+    static std::vector<byte> Build(
+        const byte* corpus, const size_t corpusSize, const std::vector<size_t>& sampleSizes, const size_t size)
+    {
+        constexpr size_t match{8};
+        constexpr size_t segmentSize{256};
+        constexpr size_t hashBits{20};
+
+        const auto dictionarySize{std::min<size_t>(size, MaximumSize)};
+
+        if (corpusSize <= dictionarySize || corpusSize < segmentSize)
+        {
+            return std::vector<byte>(corpus + corpusSize - std::min<size_t>(corpusSize, dictionarySize),
+                corpus + corpusSize);
+        }
+
+        const auto hash{[&](const size_t offset) {
+            uint64_t sequence{};
+
+            memcpy(&sequence, corpus + offset, match);
+
+            return (size_t)((sequence * 0x9e3779b185ebca87ull) >> (64 - hashBits));
+        }};
+
+        std::vector<uint32_t> counts(size_t{1} << hashBits);
+        std::vector<uint32_t> samples(size_t{1} << hashBits);
+
+        // Sequences counted once per sample
+        for (size_t sample{}, begin{}; sample < sampleSizes.size() && begin < corpusSize; ++sample)
+        {
+            const auto end{std::min<size_t>(corpusSize, begin + sampleSizes[sample])};
+
+            for (size_t offset{begin}; offset + match <= end; ++offset)
+            {
+                const auto index{hash(offset)};
+
+                if (samples[index] != sample + 1)
+                {
+                    samples[index] = (uint32_t)(sample + 1);
+                    ++counts[index];
+                }
+            }
+
+            begin = end;
+        }
+
+        // Best segment of each epoch
+        const auto segments{std::max<size_t>(1, dictionarySize / segmentSize)};
+        const auto epochSize{std::max<size_t>(segmentSize, corpusSize / segments)};
+
+        std::vector<std::pair<uint64_t, size_t>> selected;
+
+        for (size_t epoch{}; epoch + segmentSize <= corpusSize && selected.size() < segments; epoch += epochSize)
+        {
+            const auto end{std::min<size_t>(corpusSize, epoch + epochSize)};
+            uint64_t   score{};
+            uint64_t   bestScore{};
+            size_t     best{epoch};
+
+            for (size_t offset{epoch}; offset + match <= end; ++offset)
+            {
+                score += counts[hash(offset)];
+
+                if (offset >= epoch + segmentSize - match + 1)
+                {
+                    score -= counts[hash(offset - (segmentSize - match + 1))];
+                }
+                if (offset + match >= epoch + segmentSize && score > bestScore)
+                {
+                    bestScore = score;
+                    best      = offset + match - segmentSize;
+                }
+            }
+
+            if (bestScore)
+            {
+                for (size_t offset{best}; offset + match <= best + segmentSize; ++offset)
+                {
+                    counts[hash(offset)] = 0;
+                }
+
+                selected.emplace_back(bestScore, best);
+            }
+        }
+
+        std::stable_sort(selected.begin(), selected.end(), [](const auto& left, const auto& right) {
+            return left.first < right.first;
+        });
+
+        std::vector<byte> dictionary;
+
+        for (const auto& segment : selected)
+        {
+            dictionary.insert(dictionary.end(), corpus + segment.second, corpus + segment.second + segmentSize);
+        }
+
+        return dictionary;
+    }
+
+    const byte* Data{};
+    size_t      Size{};
+    uint32_t    Id{};
+};
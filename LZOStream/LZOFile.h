@@ -0,0 +1,821 @@
+/* LZOStream\LZOFile.h -- file/ stream access
+
+   This file is part of the LZOStream application for compressing/ decompressing files or streams.
+
+   Copyright (C) 2024 G DATA CyberDefense AG
+   All Rights Reserved.
+
+   The LZOStream application is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZOStream application is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZOStream application; see the file License.txt.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   G DATA CyberDefense AG
+   <source@gdata.de>
+   https://www.gdata.de/
+*/
+
+#pragma once
+#include "LZOArena.h"
+#include <algorithm>
+#include <intrin.h>
+
+class LZOFile
+{
+public:
+    const uint32_t ChunkSize{1024 * 1024 * 1024};
+    const size_t   RequestSize{1024 * 1024};
+    const size_t   SparseSize{64 * 1024};
+
+    // Mapped region of a file, unmapped on destruction
+    class View
+    {
+    public:
+        View() = default;
+        View(void* base, byte* data)
+            : _base(base)
+            , _data(data)
+        {
+        }
+        View(View&& other) noexcept
+        {
+            *this = std::move(other);
+        }
+        View& operator=(View&& other) noexcept
+        {
+            std::swap(_base, other._base);
+            std::swap(_data, other._data);
+
+            return *this;
+        }
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+        ~View()
+        {
+            if (_base)
+            {
+                UnmapViewOfFile(_base);
+            }
+        }
+
+        byte* Data() const
+        {
+            return _data;
+        }
+
+    private:
+        void* _base{};
+        byte* _data{};
+    };
+
+    LZOFile() = default;
+    LZOFile(const LZOFile&) = delete;
+    LZOFile& operator=(const LZOFile&) = delete;
+    ~LZOFile()
+    {
+        Close();
+    }
+
+    // Opens the input, a file opened with depth keeps depth overlapped reads in flight, a file opened with direct is
+    // read unbuffered (stdin is read synchronously)
+    bool OpenRead(const std::tstring& name, const uint32_t depth = 0, const bool direct = false)
+    {
+        Close();
+
+        if (name.empty())
+        {
+            _handle = GetStdHandle(STD_INPUT_HANDLE);
+
+            return Valid();
+        }
+
+        return Open(name, GENERIC_READ, OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, depth, direct);
+    }
+
+    // Opens the output, a file opened with mappable supports a writable mapping, a file opened with depth writes
+    // overlapped with up to depth writes in flight, a file opened with direct is written unbuffered (stdout is written
+    // synchronously)
+    bool OpenWrite(
+        const std::tstring& name, const bool mappable = false, const uint32_t depth = 0, const bool direct = false)
+    {
+        Close();
+
+        if (name.empty())
+        {
+            _handle = GetStdHandle(STD_OUTPUT_HANDLE);
+
+            return Valid();
+        }
+
+        _writing = true;
+
+        return Open(name, (mappable) ? GENERIC_READ | GENERIC_WRITE : GENERIC_WRITE, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL, depth, direct);
+    }
+
+    // Creates a file mapping for views, a writable mapping sets the file size to size
+    bool CreateMapping(const bool write, const uint64_t size)
+    {
+        if (!_owned || !size)
+        {
+            return false;
+        }
+
+        SYSTEM_INFO systemInfo{};
+
+        GetSystemInfo(&systemInfo);
+
+        _granularity = systemInfo.dwAllocationGranularity;
+        _write       = write;
+        _mapping     = CreateFileMapping(_handle, nullptr, (write) ? PAGE_READWRITE : PAGE_READONLY,
+            (DWORD)(size >> 32), (DWORD)size, nullptr);
+
+        return _mapping != nullptr;
+    }
+
+    bool Mapped() const
+    {
+        return _mapping != nullptr;
+    }
+
+    // Maps size bytes at offset (any offset, the view is aligned internally)
+    View Map(const uint64_t offset, const size_t size) const
+    {
+        if (!_mapping || !size)
+        {
+            return {};
+        }
+
+        const auto aligned{offset - offset % _granularity};
+        const auto base{MapViewOfFile(_mapping, (_write) ? FILE_MAP_WRITE : FILE_MAP_READ, (DWORD)(aligned >> 32),
+            (DWORD)aligned, (SIZE_T)(offset - aligned + size))};
+
+        return (base) ? View(base, (byte*)base + (offset - aligned)) : View();
+    }
+
+    void Close()
+    {
+        Flush();
+        Cancel();
+
+        for (auto& request : _requests)
+        {
+            if (request.Overlapped.hEvent)
+            {
+                CloseHandle(request.Overlapped.hEvent);
+            }
+        }
+
+        _requests.clear();
+        _position  = 0;
+        _writing   = false;
+        _direct    = false;
+        _alignment = 1;
+        _sparse    = false;
+        _holes     = 0;
+        _pending   = 0;
+
+        if (_mapping)
+        {
+            CloseHandle(_mapping);
+        }
+
+        _mapping = nullptr;
+
+        if (_owned && Valid())
+        {
+            CloseHandle(_handle);
+        }
+
+        _handle = INVALID_HANDLE_VALUE;
+        _owned  = false;
+    }
+
+    bool Valid() const
+    {
+        return _handle && _handle != INVALID_HANDLE_VALUE;
+    }
+
+    // Opened with direct and unbuffered (otherwise the file cache is used)
+    bool Direct() const
+    {
+        return _direct;
+    }
+
+    // Bytes of the system file cache, its growth over a run is the cache footprint of the buffered I/O
+    static uint64_t CacheSize()
+    {
+        PERFORMANCE_INFORMATION information{sizeof(PERFORMANCE_INFORMATION)};
+
+        return (GetPerformanceInfo(&information, sizeof(information)))
+                   ? (uint64_t)information.SystemCache * information.PageSize
+                   : 0;
+    }
+
+    // Reads until size bytes are read or the end is reached (read < size)
+    bool Read(void* data, const size_t size, size_t& read)
+    {
+        read = 0;
+
+        if (!_requests.empty())
+        {
+            return ReadQueued((byte*)data, size, read);
+        }
+
+        while (read < size)
+        {
+            const auto part{(DWORD)std::min<size_t>(size - read, ChunkSize)};
+            DWORD      chunk{};
+
+            if (!ReadFile(_handle, (byte*)data + read, part, &chunk, nullptr))
+            {
+                return GetLastError() == ERROR_BROKEN_PIPE;
+            }
+            if (!chunk)
+            {
+                break;
+            }
+
+            read += chunk;
+        }
+
+        return true;
+    }
+
+    // Writes size bytes, a sparse file skips the zero pieces of SparseSize (at multiples of SparseSize in the file)
+    // and leaves them as holes. Zeros up to the end of data in the middle of a piece are held back until the next write
+    // (or Flush) shows whether the piece stays zero.
+    bool Write(const void* data, const size_t size)
+    {
+        if (!_sparse)
+        {
+            return WritePart((const byte*)data, size);
+        }
+
+        const auto bytes{(const byte*)data};
+        auto       position{_position + _used + _pending};
+        size_t     start{};
+
+        for (size_t written{}; written < size;)
+        {
+            const auto part{std::min<size_t>(SparseSize - position % SparseSize, size - written)};
+
+            if (_pending == position % SparseSize && Zero(bytes + written, part))
+            {
+                if (!WritePart(bytes + start, written - start))
+                {
+                    return false;
+                }
+                if ((position + part) % SparseSize)
+                {
+                    _pending += part;
+                }
+                else if (!Skip(_pending + part))
+                {
+                    return false;
+                }
+                else
+                {
+                    _pending = 0;
+                }
+
+                start = written + part;
+            }
+            else if (_pending)
+            {
+                // The held back zeros are part of a piece with data
+                const std::vector<byte> zeros(_pending);
+
+                _pending = 0;
+
+                if (!WritePart(zeros.data(), zeros.size()))
+                {
+                    return false;
+                }
+            }
+
+            written += part;
+            position += part;
+        }
+
+        return WritePart(bytes + start, size - start);
+    }
+
+    // Marks the output sparse (FSCTL_SET_SPARSE) before anything is written, false if the file system has no sparse
+    // files (all bytes are written then). The file is new, so the skipped pieces need no FSCTL_SET_ZERO_DATA.
+    bool Sparse()
+    {
+        OVERLAPPED overlapped{};
+        DWORD      returned{};
+
+        if (!_writing || !_owned || _position || _used || _pending)
+        {
+            return false;
+        }
+
+        // An overlapped file needs an OVERLAPPED, the event of the first request is not in use yet
+        const auto queued{!_requests.empty()};
+
+        overlapped.hEvent = (queued) ? _requests.front().Overlapped.hEvent : nullptr;
+        _sparse           = DeviceIoControl(_handle, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &returned,
+                                (queued) ? &overlapped : nullptr) != FALSE;
+
+        if (!_sparse && queued && GetLastError() == ERROR_IO_PENDING)
+        {
+            _sparse = GetOverlappedResult(_handle, &overlapped, &returned, TRUE) != FALSE;
+        }
+
+        return _sparse;
+    }
+
+    // Bytes left as holes of a sparse file
+    uint64_t Holes() const
+    {
+        return _holes;
+    }
+
+    // Whether size bytes are zero, 64 bytes per step (SSE2)
+    static bool Zero(const byte* data, size_t size)
+    {
+        const auto zero{_mm_setzero_si128()};
+
+        for (; size >= 64; data += 64, size -= 64)
+        {
+            const auto bits{_mm_or_si128(
+                _mm_or_si128(_mm_loadu_si128((const __m128i*)data), _mm_loadu_si128((const __m128i*)(data + 16))),
+                _mm_or_si128(
+                    _mm_loadu_si128((const __m128i*)(data + 32)), _mm_loadu_si128((const __m128i*)(data + 48))))};
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(bits, zero)) != 0xffff)
+            {
+                return false;
+            }
+        }
+        for (; size; ++data, --size)
+        {
+            if (*data)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool Seekable() const
+    {
+        return GetFileType(_handle) == FILE_TYPE_DISK;
+    }
+
+    // Writes the buffered data of an overlapped output and waits for all writes (synchronous: nothing to do).
+    // A direct output writes whole sectors, the padding of the last one is cut off, a sparse output gets its size
+    // (a hole at the end is not written). The output ends here.
+    bool Flush()
+    {
+        if (!_writing || (_requests.empty() && !_sparse))
+        {
+            return true;
+        }
+
+        auto   valid{true};
+        size_t padding{};
+
+        // Zeros held back at the end stay a hole (the size is set below)
+        if (_pending)
+        {
+            valid    = Skip(_pending);
+            _pending = 0;
+        }
+        if (_used)
+        {
+            auto& request{_requests[_next]};
+
+            padding = Align(_used) - _used;
+            memset(request.Data.data() + _used, 0, padding);
+
+            valid = Start(request, _used + padding) && valid;
+            _used = 0;
+            _next = (_next + 1) % _requests.size();
+        }
+        for (auto& request : _requests)
+        {
+            valid = Complete(request) && valid;
+        }
+        if (padding || _sparse)
+        {
+            LARGE_INTEGER end{};
+
+            _position -= padding;
+            end.QuadPart = _position;
+            valid        = valid && SetFilePointerEx(_handle, end, nullptr, FILE_BEGIN) && SetEndOfFile(_handle);
+        }
+
+        return valid;
+    }
+
+    bool Seek(const uint64_t offset)
+    {
+        if (!_requests.empty())
+        {
+            // Overlapped requests carry their offset, the queue restarts at offset (direct: the sector of offset, the
+            // bytes before offset are skipped)
+            const auto valid{Flush()};
+
+            Cancel();
+            _position = offset - offset % _alignment;
+            _used     = (size_t)(offset % _alignment);
+
+            return valid;
+        }
+
+        LARGE_INTEGER value{};
+
+        value.QuadPart = offset;
+        _position      = offset;
+
+        return SetFilePointerEx(_handle, value, nullptr, FILE_BEGIN);
+    }
+
+    bool Size(uint64_t& size) const
+    {
+        LARGE_INTEGER value{};
+
+        if (!GetFileSizeEx(_handle, &value))
+        {
+            return false;
+        }
+
+        size = value.QuadPart;
+
+        return true;
+    }
+
+private:
+    // Overlapped read/ write of RequestSize bytes, the buffer is allocated once and reused by the following requests
+    struct Request
+    {
+        OVERLAPPED                            Overlapped{};
+        std::vector<byte, LZOAllocator<byte>> Data;
+        size_t                                Size{};
+        bool                                  Pending{};
+    };
+
+    // Opens a file, direct: unbuffered (FILE_FLAG_NO_BUFFERING) through the queue with requests on sector boundaries
+    // and page aligned buffers, where that is not possible buffered with FILE_FLAG_SEQUENTIAL_SCAN (the cache reuses
+    // the pages behind the position first)
+    bool Open(const std::tstring& name, const DWORD access, const DWORD disposition, const DWORD attributes,
+        const uint32_t depth, const bool direct)
+    {
+        const auto sector{(direct) ? SectorSize(name) : 0};
+
+        if (sector)
+        {
+            _handle    = CreateFile(name.data(), access, 0, nullptr, disposition,
+                attributes | FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING, nullptr);
+            _direct    = Valid();
+            _alignment = (_direct) ? sector : 1;
+        }
+        if (!_direct)
+        {
+            _handle = CreateFile(name.data(), access, 0, nullptr, disposition,
+                attributes | ((depth) ? FILE_FLAG_OVERLAPPED : 0) | ((direct) ? FILE_FLAG_SEQUENTIAL_SCAN : 0),
+                nullptr);
+        }
+
+        _owned = true;
+
+        return Valid() && Queue((_direct) ? std::max<uint32_t>(depth, 1) : depth);
+    }
+
+    // Sector size of the volume of name (the alignment of unbuffered I/O), 0 if unknown or not dividing RequestSize
+    size_t SectorSize(const std::tstring& name) const
+    {
+        TCHAR volume[MAX_PATH]{};
+        DWORD sectorsPerCluster{};
+        DWORD bytesPerSector{};
+        DWORD freeClusters{};
+        DWORD clusters{};
+
+        if (!GetVolumePathName(name.data(), volume, MAX_PATH) ||
+            !GetDiskFreeSpace(volume, &sectorsPerCluster, &bytesPerSector, &freeClusters, &clusters) ||
+            !bytesPerSector || RequestSize % bytesPerSector)
+        {
+            return 0;
+        }
+
+        return bytesPerSector;
+    }
+
+    size_t Align(const size_t size) const
+    {
+        return (size + _alignment - 1) / _alignment * _alignment;
+    }
+
+    // Sets up depth requests (file opened with FILE_FLAG_OVERLAPPED), without depth the file is synchronous
+    bool Queue(const uint32_t depth)
+    {
+        try
+        {
+            _requests = std::vector<Request>(depth);
+
+            for (auto& request : _requests)
+            {
+                request.Data.resize(RequestSize);
+                request.Overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+                if (!request.Overlapped.hEvent)
+                {
+                    return false;
+                }
+            }
+        }
+        catch (std::exception&)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    // Starts reading/ writing size bytes of request at the next file position
+    bool Start(Request& request, const size_t size)
+    {
+        request.Overlapped.Offset     = (DWORD)_position;
+        request.Overlapped.OffsetHigh = (DWORD)(_position >> 32);
+        request.Size                  = size;
+        request.Pending               = true;
+        _position += size;
+
+        const auto started{(_writing)
+                               ? WriteFile(_handle, request.Data.data(), (DWORD)size, nullptr, &request.Overlapped)
+                               : ReadFile(_handle, request.Data.data(), (DWORD)size, nullptr, &request.Overlapped)};
+
+        if (started)
+        {
+            return true;
+        }
+
+        const auto error{GetLastError()};
+
+        if (error == ERROR_IO_PENDING)
+        {
+            return true;
+        }
+
+        request.Size    = 0;
+        request.Pending = false;
+
+        // A read at or behind the end completes with nothing read
+        if (!_writing && error == ERROR_HANDLE_EOF)
+        {
+            _end = true;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    // Waits for a started request, Size gets the bytes read (a write has to be complete)
+    bool Complete(Request& request)
+    {
+        if (!request.Pending)
+        {
+            return true;
+        }
+
+        DWORD transferred{};
+
+        request.Pending = false;
+
+        if (!GetOverlappedResult(_handle, &request.Overlapped, &transferred, TRUE))
+        {
+            if (_writing || GetLastError() != ERROR_HANDLE_EOF)
+            {
+                request.Size = 0;
+
+                return false;
+            }
+
+            transferred = 0;
+        }
+        if (_writing)
+        {
+            return transferred == request.Size;
+        }
+        if (transferred < request.Size)
+        {
+            _end = true;
+        }
+
+        request.Size = transferred;
+
+        return true;
+    }
+
+    // Starts reads up to the depth of the queue until the end is reached
+    bool Fill()
+    {
+        while (!_end && _queued < _requests.size())
+        {
+            if (!Start(_requests[(_next + _queued) % _requests.size()], RequestSize))
+            {
+                return false;
+            }
+
+            ++_queued;
+        }
+
+        return true;
+    }
+
+    // Reads from the completed requests in file order, a consumed request is started again at once
+    bool ReadQueued(byte* data, const size_t size, size_t& read)
+    {
+        while (read < size)
+        {
+            if (!Fill())
+            {
+                return false;
+            }
+            if (!_queued)
+            {
+                break;
+            }
+
+            auto& request{_requests[_next]};
+
+            if (!Complete(request))
+            {
+                return false;
+            }
+
+            // After a direct seek the request starts before the offset (or ends before it at the end of the file)
+            const auto part{(request.Size > _used) ? std::min<size_t>(request.Size - _used, size - read) : 0};
+
+            memcpy(data + read, request.Data.data() + _used, part);
+            read += part;
+            _used += part;
+
+            if (_used >= request.Size)
+            {
+                _used = 0;
+                _next = (_next + 1) % _requests.size();
+                --_queued;
+            }
+        }
+
+        return Fill();
+    }
+
+    bool WritePart(const byte* data, const size_t size)
+    {
+        if (!_requests.empty())
+        {
+            return WriteQueued(data, size);
+        }
+
+        size_t written{};
+
+        while (written < size)
+        {
+            const auto part{(DWORD)std::min<size_t>(size - written, ChunkSize)};
+            DWORD      chunk{};
+
+            if (!WriteFile(_handle, data + written, part, &chunk, nullptr) || !chunk)
+            {
+                return false;
+            }
+
+            written += chunk;
+        }
+
+        _position += size;
+
+        return true;
+    }
+
+    // Leaves a hole of size bytes: the buffered data is written, the next write starts behind the hole
+    bool Skip(const size_t size)
+    {
+        if (!_requests.empty() && _used)
+        {
+            if (!Start(_requests[_next], _used))
+            {
+                return false;
+            }
+
+            _used = 0;
+            _next = (_next + 1) % _requests.size();
+        }
+        if (_requests.empty())
+        {
+            LARGE_INTEGER distance{};
+
+            distance.QuadPart = size;
+
+            if (!SetFilePointerEx(_handle, distance, nullptr, FILE_CURRENT))
+            {
+                return false;
+            }
+        }
+
+        _position += size;
+        _holes += size;
+
+        return true;
+    }
+
+    // Fills the requests in turn, a full request is written while the next one is filled
+    bool WriteQueued(const byte* data, const size_t size)
+    {
+        size_t written{};
+
+        while (written < size)
+        {
+            auto& request{_requests[_next]};
+
+            // The buffer of a request is reused once its previous write is complete
+            if (!_used && !Complete(request))
+            {
+                return false;
+            }
+
+            const auto part{std::min<size_t>(RequestSize - _used, size - written)};
+
+            memcpy(request.Data.data() + _used, data + written, part);
+            written += part;
+            _used += part;
+
+            if (_used == RequestSize)
+            {
+                if (!Start(request, _used))
+                {
+                    return false;
+                }
+
+                _used = 0;
+                _next = (_next + 1) % _requests.size();
+            }
+        }
+
+        return true;
+    }
+
+    // Cancels and waits for the requests in flight, the queue is empty afterwards
+    void Cancel()
+    {
+        if (_requests.empty())
+        {
+            return;
+        }
+
+        CancelIo(_handle);
+
+        for (auto& request : _requests)
+        {
+            DWORD transferred{};
+
+            if (request.Pending)
+            {
+                GetOverlappedResult(_handle, &request.Overlapped, &transferred, TRUE);
+            }
+
+            request.Pending = false;
+        }
+
+        _next   = 0;
+        _queued = 0;
+        _used   = 0;
+        _end    = false;
+    }
+
+    HANDLE   _handle{INVALID_HANDLE_VALUE};
+    bool     _owned{};
+    HANDLE   _mapping{};
+    bool     _write{};
+    uint32_t _granularity{};
+
+    std::vector<Request> _requests;
+    bool                 _writing{};
+    bool                 _direct{};
+    size_t               _alignment{1};
+    bool                 _sparse{};
+    uint64_t             _holes{};
+    size_t               _pending{};
+    uint64_t             _position{};
+    size_t               _next{};
+    size_t               _queued{};
+    size_t               _used{};
+    bool                 _end{};
+};
@@ -28,6 +28,13 @@
 #pragma once
 #include <map>
 
+// The assembler decompressors of LZO (lzo_asm.h) are available for x86 only
+#ifdef _M_IX86
+#define LZO_ASM(function) function
+#else
+#define LZO_ASM(function) nullptr
+#endif
+
 static constexpr uint32_t MakeId(const char* string)
 {
     auto id{(uint32_t)-1};
@@ -90,6 +97,10 @@ public:
         Lzo1z_999  = MakeId("Lzo1z_999"),
         Lzo2a      = MakeId("Lzo2a"),
         Lzo2a_999  = MakeId("Lzo2a_999"),
+        Stream     = MakeId("Stream"),
+        Index      = MakeId("Index"),
+        Directory  = MakeId("Directory"),
+        Fill       = MakeId("Fill"),
         Default    = Lzo1x_999
     };
 
@@ -101,13 +112,52 @@ public:
         }
     };
 
+    // Compression with a level 1 (fastest) ... 9 (best ratio) and an optional preset dictionary
+    using CompressLevel = int (*)(const lzo_bytep source, lzo_uint sourceSize, lzo_bytep destination,
+        lzo_uintp destinationSize, lzo_voidp work, const lzo_bytep dictionary, lzo_uint dictionarySize,
+        lzo_callback_p callback, int level);
+
+    // Decompressors: Safe checks the bounds of input and output, Fast (the default of LZO) trusts the data, Asm are the
+    // assembler versions of Fast (x86) that may write up to AsmSlack bytes behind the decompressed data
+    enum class Decoder
+    {
+        Safe,
+        Fast,
+        Asm
+    };
+
+    static constexpr size_t AsmSlack{3};
+
     struct Info
     {
-        const char*      Name{};
-        lzo_compress_t   FunctionCompress{};
-        lzo_decompress_t FunctionDecompress{};
-        uint32_t         MemoryCompress{};
-        uint32_t         MemoryDecompress{};
+        // Decompressor of decoder for data that is trusted (verified by its hash) or not with slack bytes behind the
+        // target: untrusted data is always decompressed safe, Asm without slack fast. Lzo1 and Lzo1a have no safe
+        // decompressor, for Safe or untrusted data they have none (nullptr).
+        lzo_decompress_t Decompressor(const Decoder decoder, const bool trusted, const size_t slack = 0) const
+        {
+            if (decoder == Decoder::Safe || !trusted)
+            {
+                return FunctionDecompressSafe;
+            }
+            if (decoder == Decoder::Asm && trusted && slack >= AsmSlack && FunctionDecompressAsm)
+            {
+                return FunctionDecompressAsm;
+            }
+
+            return FunctionDecompress;
+        }
+
+        const char*           Name{};
+        lzo_compress_t        FunctionCompress{};
+        lzo_decompress_t      FunctionDecompress{};
+        uint32_t              MemoryCompress{};
+        uint32_t              MemoryDecompress{};
+        lzo_decompress_t      FunctionDecompressSafe{}; // Decompression that checks the bounds (Decoder::Safe)
+        lzo_decompress_t      FunctionDecompressAsm{};  // Assembler decompression (Decoder::Asm, x86 only)
+        lzo_compress_dict_t   FunctionCompressDict{};   // Compression with a preset dictionary (LZODictionary)
+        lzo_decompress_dict_t FunctionDecompressDict{}; // Decompression with a preset dictionary
+        CompressLevel         FunctionCompressLevel{};  // Compression with a level (default of FunctionCompress: 8)
+        lzo_optimize_t        FunctionOptimize{};       // Rewrites compressed data in place for faster decompression
     };
 
     static const std::map<LPCTSTR, Id, LessNoCase>& FormatIds()
@@ -139,58 +189,140 @@ public:
             {Id::Lzo1a, {"Lzo1a", lzo1a_compress, lzo1a_decompress, LZO1A_MEM_COMPRESS, LZO1A_MEM_DECOMPRESS}},
             {Id::Lzo1a_99,
                 {"Lzo1a_99", lzo1a_99_compress, lzo1a_decompress, LZO1A_99_MEM_COMPRESS, LZO1A_MEM_DECOMPRESS}},
-            {Id::Lzo1b, {"Lzo1b", lzo1b_999_compress, lzo1b_decompress, LZO1B_999_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
-            {Id::Lzo1b_1, {"Lzo1b_1", lzo1b_1_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
-            {Id::Lzo1b_2, {"Lzo1b_2", lzo1b_2_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
-            {Id::Lzo1b_3, {"Lzo1b_3", lzo1b_3_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
-            {Id::Lzo1b_4, {"Lzo1b_4", lzo1b_4_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
-            {Id::Lzo1b_5, {"Lzo1b_5", lzo1b_5_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
-            {Id::Lzo1b_6, {"Lzo1b_6", lzo1b_6_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
-            {Id::Lzo1b_7, {"Lzo1b_7", lzo1b_7_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
-            {Id::Lzo1b_8, {"Lzo1b_8", lzo1b_8_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
-            {Id::Lzo1b_9, {"Lzo1b_9", lzo1b_9_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
+            {Id::Lzo1b,
+                {"Lzo1b", lzo1b_999_compress, lzo1b_decompress, LZO1B_999_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
+            {Id::Lzo1b_1,
+                {"Lzo1b_1", lzo1b_1_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
+            {Id::Lzo1b_2,
+                {"Lzo1b_2", lzo1b_2_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
+            {Id::Lzo1b_3,
+                {"Lzo1b_3", lzo1b_3_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
+            {Id::Lzo1b_4,
+                {"Lzo1b_4", lzo1b_4_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
+            {Id::Lzo1b_5,
+                {"Lzo1b_5", lzo1b_5_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
+            {Id::Lzo1b_6,
+                {"Lzo1b_6", lzo1b_6_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
+            {Id::Lzo1b_7,
+                {"Lzo1b_7", lzo1b_7_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
+            {Id::Lzo1b_8,
+                {"Lzo1b_8", lzo1b_8_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
+            {Id::Lzo1b_9,
+                {"Lzo1b_9", lzo1b_9_compress, lzo1b_decompress, LZO1B_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
             {Id::Lzo1b_99,
-                {"Lzo1b_99", lzo1b_99_compress, lzo1b_decompress, LZO1B_99_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
+                {"Lzo1b_99", lzo1b_99_compress, lzo1b_decompress, LZO1B_99_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
             {Id::Lzo1b_999,
-                {"Lzo1b_999", lzo1b_999_compress, lzo1b_decompress, LZO1B_999_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS}},
-            {Id::Lzo1c, {"Lzo1c", lzo1c_999_compress, lzo1c_decompress, LZO1C_999_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
-            {Id::Lzo1c_1, {"Lzo1c_1", lzo1c_1_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
-            {Id::Lzo1c_2, {"Lzo1c_2", lzo1c_2_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
-            {Id::Lzo1c_3, {"Lzo1c_3", lzo1c_3_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
-            {Id::Lzo1c_4, {"Lzo1c_4", lzo1c_4_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
-            {Id::Lzo1c_5, {"Lzo1c_5", lzo1c_5_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
-            {Id::Lzo1c_6, {"Lzo1c_6", lzo1c_6_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
-            {Id::Lzo1c_7, {"Lzo1c_7", lzo1c_7_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
-            {Id::Lzo1c_8, {"Lzo1c_8", lzo1c_8_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
-            {Id::Lzo1c_9, {"Lzo1c_9", lzo1c_9_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
+                {"Lzo1b_999", lzo1b_999_compress, lzo1b_decompress, LZO1B_999_MEM_COMPRESS, LZO1B_MEM_DECOMPRESS,
+                    lzo1b_decompress_safe}},
+            {Id::Lzo1c,
+                {"Lzo1c", lzo1c_999_compress, lzo1c_decompress, LZO1C_999_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
+            {Id::Lzo1c_1,
+                {"Lzo1c_1", lzo1c_1_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
+            {Id::Lzo1c_2,
+                {"Lzo1c_2", lzo1c_2_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
+            {Id::Lzo1c_3,
+                {"Lzo1c_3", lzo1c_3_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
+            {Id::Lzo1c_4,
+                {"Lzo1c_4", lzo1c_4_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
+            {Id::Lzo1c_5,
+                {"Lzo1c_5", lzo1c_5_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
+            {Id::Lzo1c_6,
+                {"Lzo1c_6", lzo1c_6_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
+            {Id::Lzo1c_7,
+                {"Lzo1c_7", lzo1c_7_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
+            {Id::Lzo1c_8,
+                {"Lzo1c_8", lzo1c_8_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
+            {Id::Lzo1c_9,
+                {"Lzo1c_9", lzo1c_9_compress, lzo1c_decompress, LZO1C_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
             {Id::Lzo1c_99,
-                {"Lzo1c_99", lzo1c_99_compress, lzo1c_decompress, LZO1C_99_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
+                {"Lzo1c_99", lzo1c_99_compress, lzo1c_decompress, LZO1C_99_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
             {Id::Lzo1c_999,
-                {"Lzo1c_999", lzo1c_999_compress, lzo1c_decompress, LZO1C_999_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS}},
-            {Id::Lzo1f, {"Lzo1f", lzo1f_999_compress, lzo1f_decompress, LZO1F_999_MEM_COMPRESS, LZO1F_MEM_DECOMPRESS}},
-            {Id::Lzo1f_1, {"Lzo1f_1", lzo1f_1_compress, lzo1f_decompress, LZO1F_MEM_COMPRESS, LZO1F_MEM_DECOMPRESS}},
+                {"Lzo1c_999", lzo1c_999_compress, lzo1c_decompress, LZO1C_999_MEM_COMPRESS, LZO1C_MEM_DECOMPRESS,
+                    lzo1c_decompress_safe, LZO_ASM(lzo1c_decompress_asm)}},
+            {Id::Lzo1f,
+                {"Lzo1f", lzo1f_999_compress, lzo1f_decompress, LZO1F_999_MEM_COMPRESS, LZO1F_MEM_DECOMPRESS,
+                    lzo1f_decompress_safe, LZO_ASM(lzo1f_decompress_asm_fast)}},
+            {Id::Lzo1f_1,
+                {"Lzo1f_1", lzo1f_1_compress, lzo1f_decompress, LZO1F_MEM_COMPRESS, LZO1F_MEM_DECOMPRESS,
+                    lzo1f_decompress_safe, LZO_ASM(lzo1f_decompress_asm_fast)}},
             {Id::Lzo1f_999,
-                {"Lzo1f_999", lzo1f_999_compress, lzo1f_decompress, LZO1F_999_MEM_COMPRESS, LZO1F_MEM_DECOMPRESS}},
-            {Id::Lzo1x, {"Lzo1x", lzo1x_999_compress, lzo1x_decompress, LZO1X_999_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS}},
-            {Id::Lzo1x_1, {"Lzo1x_1", lzo1x_1_compress, lzo1x_decompress, LZO1X_1_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS}},
+                {"Lzo1f_999", lzo1f_999_compress, lzo1f_decompress, LZO1F_999_MEM_COMPRESS, LZO1F_MEM_DECOMPRESS,
+                    lzo1f_decompress_safe, LZO_ASM(lzo1f_decompress_asm_fast)}},
+            {Id::Lzo1x,
+                {"Lzo1x", lzo1x_999_compress, lzo1x_decompress, LZO1X_999_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS,
+                    lzo1x_decompress_safe, LZO_ASM(lzo1x_decompress_asm_fast), lzo1x_999_compress_dict,
+                    lzo1x_decompress_dict_safe, lzo1x_999_compress_level, lzo1x_optimize}},
+            {Id::Lzo1x_1,
+                {"Lzo1x_1", lzo1x_1_compress, lzo1x_decompress, LZO1X_1_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS,
+                    lzo1x_decompress_safe, LZO_ASM(lzo1x_decompress_asm_fast), nullptr, nullptr, nullptr,
+                    lzo1x_optimize}},
             {Id::Lzo1x_1_11,
-                {"Lzo1x_1_11", lzo1x_1_11_compress, lzo1x_decompress, LZO1X_1_11_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS}},
+                {"Lzo1x_1_11", lzo1x_1_11_compress, lzo1x_decompress, LZO1X_1_11_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS,
+                    lzo1x_decompress_safe, LZO_ASM(lzo1x_decompress_asm_fast), nullptr, nullptr, nullptr,
+                    lzo1x_optimize}},
             {Id::Lzo1x_1_12,
-                {"Lzo1x_1_12", lzo1x_1_12_compress, lzo1x_decompress, LZO1X_1_12_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS}},
+                {"Lzo1x_1_12", lzo1x_1_12_compress, lzo1x_decompress, LZO1X_1_12_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS,
+                    lzo1x_decompress_safe, LZO_ASM(lzo1x_decompress_asm_fast), nullptr, nullptr, nullptr,
+                    lzo1x_optimize}},
             {Id::Lzo1x_1_15,
-                {"Lzo1x_1_15", lzo1x_1_15_compress, lzo1x_decompress, LZO1X_1_15_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS}},
+                {"Lzo1x_1_15", lzo1x_1_15_compress, lzo1x_decompress, LZO1X_1_15_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS,
+                    lzo1x_decompress_safe, LZO_ASM(lzo1x_decompress_asm_fast), nullptr, nullptr, nullptr,
+                    lzo1x_optimize}},
             {Id::Lzo1x_999,
-                {"Lzo1x_999", lzo1x_999_compress, lzo1x_decompress, LZO1X_999_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS}},
-            {Id::Lzo1y, {"Lzo1y", lzo1y_999_compress, lzo1y_decompress, LZO1Y_999_MEM_COMPRESS, LZO1Y_MEM_DECOMPRESS}},
-            {Id::Lzo1y_1, {"Lzo1y_1", lzo1y_1_compress, lzo1y_decompress, LZO1Y_MEM_COMPRESS, LZO1Y_MEM_DECOMPRESS}},
+                {"Lzo1x_999", lzo1x_999_compress, lzo1x_decompress, LZO1X_999_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS,
+                    lzo1x_decompress_safe, LZO_ASM(lzo1x_decompress_asm_fast), lzo1x_999_compress_dict,
+                    lzo1x_decompress_dict_safe, lzo1x_999_compress_level, lzo1x_optimize}},
+            {Id::Lzo1y,
+                {"Lzo1y", lzo1y_999_compress, lzo1y_decompress, LZO1Y_999_MEM_COMPRESS, LZO1Y_MEM_DECOMPRESS,
+                    lzo1y_decompress_safe, LZO_ASM(lzo1y_decompress_asm_fast), lzo1y_999_compress_dict,
+                    lzo1y_decompress_dict_safe, lzo1y_999_compress_level, lzo1y_optimize}},
+            {Id::Lzo1y_1,
+                {"Lzo1y_1", lzo1y_1_compress, lzo1y_decompress, LZO1Y_MEM_COMPRESS, LZO1Y_MEM_DECOMPRESS,
+                    lzo1y_decompress_safe, LZO_ASM(lzo1y_decompress_asm_fast), nullptr, nullptr, nullptr,
+                    lzo1y_optimize}},
             {Id::Lzo1y_999,
-                {"Lzo1y_999", lzo1y_999_compress, lzo1y_decompress, LZO1Y_999_MEM_COMPRESS, LZO1Y_MEM_DECOMPRESS}},
-            {Id::Lzo1z, {"Lzo1z", lzo1z_999_compress, lzo1z_decompress, LZO1Z_999_MEM_COMPRESS, LZO1Z_MEM_DECOMPRESS}},
+                {"Lzo1y_999", lzo1y_999_compress, lzo1y_decompress, LZO1Y_999_MEM_COMPRESS, LZO1Y_MEM_DECOMPRESS,
+                    lzo1y_decompress_safe, LZO_ASM(lzo1y_decompress_asm_fast), lzo1y_999_compress_dict,
+                    lzo1y_decompress_dict_safe, lzo1y_999_compress_level, lzo1y_optimize}},
+            {Id::Lzo1z,
+                {"Lzo1z", lzo1z_999_compress, lzo1z_decompress, LZO1Z_999_MEM_COMPRESS, LZO1Z_MEM_DECOMPRESS,
+                    lzo1z_decompress_safe, nullptr, lzo1z_999_compress_dict, lzo1z_decompress_dict_safe,
+                    lzo1z_999_compress_level}},
             {Id::Lzo1z_999,
-                {"Lzo1z_999", lzo1z_999_compress, lzo1z_decompress, LZO1Z_999_MEM_COMPRESS, LZO1Z_MEM_DECOMPRESS}},
-            {Id::Lzo2a, {"Lzo2a", lzo2a_999_compress, lzo2a_decompress, LZO2A_999_MEM_COMPRESS, LZO2A_MEM_DECOMPRESS}},
+                {"Lzo1z_999", lzo1z_999_compress, lzo1z_decompress, LZO1Z_999_MEM_COMPRESS, LZO1Z_MEM_DECOMPRESS,
+                    lzo1z_decompress_safe, nullptr, lzo1z_999_compress_dict, lzo1z_decompress_dict_safe,
+                    lzo1z_999_compress_level}},
+            {Id::Lzo2a,
+                {"Lzo2a", lzo2a_999_compress, lzo2a_decompress, LZO2A_999_MEM_COMPRESS, LZO2A_MEM_DECOMPRESS,
+                    lzo2a_decompress_safe}},
             {Id::Lzo2a_999,
-                {"Lzo2a_999", lzo2a_999_compress, lzo2a_decompress, LZO2A_999_MEM_COMPRESS, LZO2A_MEM_DECOMPRESS}}};
+                {"Lzo2a_999", lzo2a_999_compress, lzo2a_decompress, LZO2A_999_MEM_COMPRESS, LZO2A_MEM_DECOMPRESS,
+                    lzo2a_decompress_safe}},
+            {Id::Stream, {"Stream", nullptr, nullptr, 0, 0}},
+            {Id::Index, {"Index", nullptr, nullptr, 0, 0}}, {Id::Directory, {"Directory", nullptr, nullptr, 0, 0}},
+            {Id::Fill, {"Fill", nullptr, nullptr, 0, 0}}};
 
         return formatInfos;
     }
@@ -0,0 +1,520 @@
+/* LZOStream\LZOHash.h -- Adler-32 with SIMD kernels selected for the CPU
+
+   This file is part of the LZOStream application for compressing/ decompressing files or streams.
+
+   Copyright (C) 2024 G DATA CyberDefense AG
+   All Rights Reserved.
+
+   The LZOStream application is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZOStream application is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZOStream application; see the file License.txt.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   G DATA CyberDefense AG
+   <source@gdata.de>
+   https://www.gdata.de/
+*/
+
+#pragma once
+#include <intrin.h>
+#include <vector>
+
+// Checksums of the header hashes: Adler-32 (bit exact with lzo_adler32) with SSSE3, AVX2 and AVX-512 kernels, CRC-32C
+// with the SSE4.2 crc32 instruction and XXH64 (the low 32 bits), the fastest kernel supported by the CPU is selected at
+// first use. Each Adler-32 kernel sums blocks of 32 or 64 bytes in vector lanes: s1 with the byte sums, s2 with the
+// bytes weighted by their distance to the block end plus the block size times the s1 sums of the previous blocks.
+class LZOHash
+{
+public:
+    // Values are the version byte of the header id
+    enum class Checksum : uint8_t
+    {
+        Adler32 = 'O',
+        Crc32c  = 'C',
+        Xxh64   = 'X',
+        None    = 'N'
+    };
+
+    using Function = uint32_t (*)(uint32_t value, const byte* data, size_t size);
+
+    struct Kernel
+    {
+        const char* Name{};
+        Checksum    Type{};
+        Function    Hash{};
+        bool        Supported{};
+    };
+
+    explicit LZOHash(const Checksum checksum = Checksum::Adler32) : _checksum{checksum}
+    {
+        _lanes[0] = Prime1 + Prime2;
+        _lanes[1] = Prime2;
+        _lanes[2] = 0;
+        _lanes[3] = 0 - Prime1;
+    }
+
+    // Continues the hash with data
+    void Update(const byte* data, size_t size)
+    {
+        if (_checksum == Checksum::Adler32)
+        {
+            _value = Adler32(_value, data, size);
+        }
+        else if (_checksum == Checksum::Crc32c)
+        {
+            _value = Crc32c(_value, data, size);
+        }
+        else if (_checksum == Checksum::Xxh64)
+        {
+            _total += size;
+
+            if (_buffered)
+            {
+                const auto count{std::min<size_t>(size, sizeof(_buffer) - _buffered)};
+
+                memcpy(_buffer + _buffered, data, count);
+                _buffered += count;
+                data += count;
+                size -= count;
+
+                if (_buffered < sizeof(_buffer))
+                {
+                    return;
+                }
+
+                Stripe(_buffer);
+                _buffered = 0;
+            }
+            for (; size >= sizeof(_buffer); data += sizeof(_buffer), size -= sizeof(_buffer))
+            {
+                Stripe(data);
+            }
+
+            memcpy(_buffer, data, size);
+            _buffered = size;
+        }
+    }
+
+    uint32_t Value() const
+    {
+        if (_checksum != Checksum::Xxh64)
+        {
+            return _value;
+        }
+
+        uint64_t hash{(_total >= sizeof(_buffer))
+                          ? Merge(Merge(Merge(Merge(Rotate(_lanes[0], 1) + Rotate(_lanes[1], 7) +
+                                                        Rotate(_lanes[2], 12) + Rotate(_lanes[3], 18),
+                                                    _lanes[0]),
+                                              _lanes[1]),
+                                        _lanes[2]),
+                                _lanes[3])
+                          : Prime5};
+        size_t   index{};
+
+        hash += _total;
+
+        for (; index + 8 <= _buffered; index += 8)
+        {
+            hash ^= Round(0, Read64(_buffer + index));
+            hash = Rotate(hash, 27) * Prime1 + Prime4;
+        }
+        for (; index + 4 <= _buffered; index += 4)
+        {
+            hash ^= Read32(_buffer + index) * Prime1;
+            hash = Rotate(hash, 23) * Prime2 + Prime3;
+        }
+        for (; index < _buffered; ++index)
+        {
+            hash ^= _buffer[index] * Prime5;
+            hash = Rotate(hash, 11) * Prime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= Prime2;
+        hash ^= hash >> 29;
+        hash *= Prime3;
+        hash ^= hash >> 32;
+
+        return (uint32_t)hash;
+    }
+
+    // Hash of data with checksum (0 with None)
+    static uint32_t Hash(const Checksum checksum, const byte* data, const size_t size)
+    {
+        LZOHash hash{checksum};
+
+        hash.Update(data, size);
+
+        return hash.Value();
+    }
+
+    static bool Known(const Checksum checksum)
+    {
+        return Name(checksum) != nullptr;
+    }
+
+    static const char* Name(const Checksum checksum)
+    {
+        switch (checksum)
+        {
+        case Checksum::Adler32:
+            return "adler32";
+        case Checksum::Crc32c:
+            return "crc32c";
+        case Checksum::Xxh64:
+            return "xxh64";
+        case Checksum::None:
+            return "none";
+        }
+
+        return nullptr;
+    }
+
+    // Kernels of all checksums from scalar to the widest vectors
+    static const std::vector<Kernel>& Kernels()
+    {
+        static const std::vector<Kernel> kernels{Detect()};
+
+        return kernels;
+    }
+
+    static uint32_t Adler32(const uint32_t adler, const byte* data, const size_t size)
+    {
+        static const auto function{Select(Checksum::Adler32)};
+
+        return function(adler, data, size);
+    }
+
+    static uint32_t Crc32c(const uint32_t crc, const byte* data, const size_t size)
+    {
+        static const auto function{Select(Checksum::Crc32c)};
+
+        return function(crc, data, size);
+    }
+
+private:
+    // Largest prime below 2^16
+    static constexpr uint32_t Base{65521};
+    // Most bytes summed before s2 could overflow 32 bits
+    static constexpr size_t Maximum{5552};
+    // Reversed CRC-32C (Castagnoli) polynomial
+    static constexpr uint32_t Polynomial{0x82f63b78};
+    // XXH64 primes
+    static constexpr uint64_t Prime1{0x9e3779b185ebca87};
+    static constexpr uint64_t Prime2{0xc2b2ae3d27d4eb4f};
+    static constexpr uint64_t Prime3{0x165667b19e3779f9};
+    static constexpr uint64_t Prime4{0x85ebca77c2b2ae63};
+    static constexpr uint64_t Prime5{0x27d4eb2f165667c5};
+
+    static std::vector<Kernel> Detect()
+    {
+        int  info[4]{};
+        bool ssse3{};
+        bool sse42{};
+        bool avx2{};
+        bool avx512{};
+
+        __cpuid(info, 0);
+
+        const auto ids{info[0]};
+
+        __cpuid(info, 1);
+        ssse3 = (info[2] & (1 << 9)) != 0;
+        sse42 = (info[2] & (1 << 20)) != 0;
+
+        if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ids >= 7)
+        {
+            const auto xcr0{_xgetbv(0)};
+
+            __cpuidex(info, 7, 0);
+            avx2   = (xcr0 & 0x06) == 0x06 && (info[1] & (1 << 5));
+            avx512 = (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)) && (info[1] & (1 << 30));
+        }
+
+        return {{"Adler32_Scalar", Checksum::Adler32, Adler32Scalar, true},
+            {"Adler32_SSSE3", Checksum::Adler32, Adler32Ssse3, ssse3},
+            {"Adler32_AVX2", Checksum::Adler32, Adler32Avx2, avx2},
+            {"Adler32_AVX-512", Checksum::Adler32, Adler32Avx512, avx512},
+            {"Crc32c_Scalar", Checksum::Crc32c, Crc32cScalar, true},
+            {"Crc32c_SSE4.2", Checksum::Crc32c, Crc32cSse42, sse42},
+            {"Xxh64_Scalar", Checksum::Xxh64, Xxh64Scalar, true}};
+    }
+
+    static Function Select(const Checksum checksum)
+    {
+        Function function{};
+
+        for (const auto& kernel : Kernels())
+        {
+            function = (kernel.Supported && kernel.Type == checksum) ? kernel.Hash : function;
+        }
+
+        return function;
+    }
+
+    static uint64_t Rotate(const uint64_t value, const int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static uint64_t Read64(const byte* data)
+    {
+        uint64_t value;
+
+        memcpy(&value, data, sizeof(value));
+
+        return value;
+    }
+
+    static uint64_t Read32(const byte* data)
+    {
+        uint32_t value;
+
+        memcpy(&value, data, sizeof(value));
+
+        return value;
+    }
+
+    static uint64_t Round(const uint64_t lane, const uint64_t value)
+    {
+        return Rotate(lane + value * Prime2, 31) * Prime1;
+    }
+
+    static uint64_t Merge(const uint64_t hash, const uint64_t lane)
+    {
+        return (hash ^ Round(0, lane)) * Prime1 + Prime4;
+    }
+
+    // Adds 32 bytes to the XXH64 lanes
+    void Stripe(const byte* data)
+    {
+        for (size_t lane{}; lane < 4; ++lane)
+        {
+            _lanes[lane] = Round(_lanes[lane], Read64(data + lane * 8));
+        }
+    }
+
+    static uint32_t Xxh64Scalar(const uint32_t, const byte* data, const size_t size)
+    {
+        return Hash(Checksum::Xxh64, data, size);
+    }
+
+    static uint32_t Crc32cScalar(uint32_t crc, const byte* data, const size_t size)
+    {
+        static const auto table{[]() {
+            std::vector<uint32_t> table(256);
+
+            for (uint32_t index{}; index < table.size(); ++index)
+            {
+                uint32_t value{index};
+
+                for (int bit{}; bit < 8; ++bit)
+                {
+                    value = (value & 1) ? (value >> 1) ^ Polynomial : value >> 1;
+                }
+
+                table[index] = value;
+            }
+
+            return table;
+        }()};
+
+        crc = ~crc;
+
+        for (size_t index{}; index < size; ++index)
+        {
+            crc = table[(crc ^ data[index]) & 0xff] ^ (crc >> 8);
+        }
+
+        return ~crc;
+    }
+
+    static uint32_t Crc32cSse42(uint32_t crc, const byte* data, size_t size)
+    {
+        crc = ~crc;
+
+#ifdef _M_X64
+        uint64_t crc64{crc};
+
+        for (; size >= 8; data += 8, size -= 8)
+        {
+            crc64 = _mm_crc32_u64(crc64, Read64(data));
+        }
+
+        crc = (uint32_t)crc64;
+#else
+        for (; size >= 4; data += 4, size -= 4)
+        {
+            crc = _mm_crc32_u32(crc, (uint32_t)Read32(data));
+        }
+#endif
+        for (; size; ++data, --size)
+        {
+            crc = _mm_crc32_u8(crc, *data);
+        }
+
+        return ~crc;
+    }
+
+    static uint32_t Adler32Scalar(const uint32_t adler, const byte* data, const size_t size)
+    {
+        return lzo_adler32(adler, data, (lzo_uint)size);
+    }
+
+    // Sums the remaining bytes
+    static uint32_t Tail(uint32_t s1, uint32_t s2, const byte* data, size_t size)
+    {
+        while (size)
+        {
+            const auto count{std::min<size_t>(size, Maximum)};
+
+            for (size_t index{}; index < count; ++index)
+            {
+                s1 += data[index];
+                s2 += s1;
+            }
+
+            data += count;
+            size -= count;
+            s1 %= Base;
+            s2 %= Base;
+        }
+
+        return (s2 << 16) | s1;
+    }
+
+    static uint32_t Sum(__m128i sum)
+    {
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        return (uint32_t)_mm_cvtsi128_si32(sum);
+    }
+
+    static uint32_t Adler32Ssse3(const uint32_t adler, const byte* data, size_t size)
+    {
+        const auto zero{_mm_setzero_si128()};
+        const auto ones{_mm_set1_epi16(1)};
+        const auto taps1{_mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17)};
+        const auto taps2{_mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)};
+        uint32_t   s1{adler & 0xffff};
+        uint32_t   s2{adler >> 16};
+
+        while (size >= 32)
+        {
+            const auto blocks{std::min<size_t>(size / 32, Maximum / 32)};
+            auto       prefix{_mm_cvtsi32_si128((int)(s1 * blocks))};
+            auto       sum1{_mm_setzero_si128()};
+            auto       sum2{_mm_cvtsi32_si128((int)s2)};
+
+            for (size_t block{}; block < blocks; ++block, data += 32)
+            {
+                const auto bytes1{_mm_loadu_si128((const __m128i*)data)};
+                const auto bytes2{_mm_loadu_si128((const __m128i*)(data + 16))};
+
+                prefix = _mm_add_epi32(prefix, sum1);
+                sum1   = _mm_add_epi32(sum1, _mm_add_epi32(_mm_sad_epu8(bytes1, zero), _mm_sad_epu8(bytes2, zero)));
+                sum2   = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, taps1), ones));
+                sum2   = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, taps2), ones));
+            }
+
+            s1 = (s1 + Sum(sum1)) % Base;
+            s2 = Sum(_mm_add_epi32(sum2, _mm_slli_epi32(prefix, 5))) % Base;
+            size -= blocks * 32;
+        }
+
+        return Tail(s1, s2, data, size);
+    }
+
+    static uint32_t Adler32Avx2(const uint32_t adler, const byte* data, size_t size)
+    {
+        const auto zero{_mm256_setzero_si256()};
+        const auto ones{_mm256_set1_epi16(1)};
+        const auto taps1{_mm256_setr_epi8(64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48, 47, 46,
+            45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33)};
+        const auto taps2{_mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14,
+            13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)};
+        uint32_t   s1{adler & 0xffff};
+        uint32_t   s2{adler >> 16};
+
+        while (size >= 64)
+        {
+            const auto blocks{std::min<size_t>(size / 64, Maximum / 64)};
+            auto       prefix{_mm256_setr_epi32((int)(s1 * blocks), 0, 0, 0, 0, 0, 0, 0)};
+            auto       sum1{_mm256_setzero_si256()};
+            auto       sum2{_mm256_setr_epi32((int)s2, 0, 0, 0, 0, 0, 0, 0)};
+
+            for (size_t block{}; block < blocks; ++block, data += 64)
+            {
+                const auto bytes1{_mm256_loadu_si256((const __m256i*)data)};
+                const auto bytes2{_mm256_loadu_si256((const __m256i*)(data + 32))};
+
+                prefix = _mm256_add_epi32(prefix, sum1);
+                sum1   = _mm256_add_epi32(
+                    sum1, _mm256_add_epi32(_mm256_sad_epu8(bytes1, zero), _mm256_sad_epu8(bytes2, zero)));
+                sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes1, taps1), ones));
+                sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes2, taps2), ones));
+            }
+
+            sum2 = _mm256_add_epi32(sum2, _mm256_slli_epi32(prefix, 6));
+            s1   = (s1 + Sum(_mm_add_epi32(_mm256_castsi256_si128(sum1), _mm256_extracti128_si256(sum1, 1)))) % Base;
+            s2   = Sum(_mm_add_epi32(_mm256_castsi256_si128(sum2), _mm256_extracti128_si256(sum2, 1))) % Base;
+            size -= blocks * 64;
+        }
+
+        return Tail(s1, s2, data, size);
+    }
+
+    static uint32_t Adler32Avx512(const uint32_t adler, const byte* data, size_t size)
+    {
+        const auto zero{_mm512_setzero_si512()};
+        const auto ones{_mm512_set1_epi16(1)};
+        const auto taps{_mm512_set_epi8(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22,
+            23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49,
+            50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64)};
+        uint32_t   s1{adler & 0xffff};
+        uint32_t   s2{adler >> 16};
+
+        while (size >= 64)
+        {
+            const auto blocks{std::min<size_t>(size / 64, Maximum / 64)};
+            auto       prefix{_mm512_setzero_si512()};
+            auto       sum1{_mm512_setzero_si512()};
+            auto       sum2{_mm512_setzero_si512()};
+
+            for (size_t block{}; block < blocks; ++block, data += 64)
+            {
+                const auto bytes{_mm512_loadu_si512(data)};
+
+                prefix = _mm512_add_epi32(prefix, sum1);
+                sum1   = _mm512_add_epi32(sum1, _mm512_sad_epu8(bytes, zero));
+                sum2   = _mm512_add_epi32(sum2, _mm512_madd_epi16(_mm512_maddubs_epi16(bytes, taps), ones));
+            }
+
+            sum2 = _mm512_add_epi32(sum2, _mm512_slli_epi32(prefix, 6));
+            s2   = (s2 + (uint32_t)(s1 * blocks * 64) + (uint32_t)_mm512_reduce_add_epi32(sum2)) % Base;
+            s1   = (s1 + (uint32_t)_mm512_reduce_add_epi32(sum1)) % Base;
+            size -= blocks * 64;
+        }
+
+        return Tail(s1, s2, data, size);
+    }
+
+    Checksum _checksum{};
+    uint32_t _value{};
+    uint64_t _lanes[4]{};
+    byte     _buffer[32]{};
+    size_t   _buffered{};
+    uint64_t _total{};
+};
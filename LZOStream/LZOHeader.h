@@ -27,16 +27,25 @@
 
 #pragma once
 #include "LZOFormat.h"
+#include "LZOHash.h"
 
-constexpr uint32_t LZOHeaderId{'L' | ('Z' << 8) | ('O' << 16) | (28 << 24)};
+// Header id of a version: 'L' 'Z', the checksum of the hashes ('O' Adler-32 of the first version) and the header size
+constexpr uint32_t LZOHeaderVersion(const uint32_t size, const LZOHash::Checksum checksum = LZOHash::Checksum::Adler32)
+{
+    return 'L' | ('Z' << 8) | ((uint32_t)checksum << 16) | (size << 24);
+}
+
+constexpr uint32_t LZOHeaderId{LZOHeaderVersion(28)};
+constexpr uint32_t LZOHeader64Id{LZOHeaderVersion(40)};
 
 class LZOHeader
 {
 public:
     void Initialize(const LZOFormat::Id formatId, const uint32_t sourceSize, const uint32_t destinationSize,
-        const uint32_t sourceHash = {}, const uint32_t destinationHash = {})
+        const uint32_t sourceHash = {}, const uint32_t destinationHash = {},
+        const LZOHash::Checksum checksum = LZOHash::Checksum::Adler32)
     {
-        HeaderId        = LZOHeaderId;
+        HeaderId        = LZOHeaderVersion(sizeof(LZOHeader), checksum);
         FormatId        = formatId;
         SourceSize      = sourceSize;
         DestinationSize = destinationSize;
@@ -55,6 +64,19 @@ public:
         return HeaderHash == HeaderCrc32(this, sizeof(*this));
     }
 
+    // Checksum of the hashes (from the header id)
+    LZOHash::Checksum Checksum() const
+    {
+        return (LZOHash::Checksum)((HeaderId >> 16) & 0xff);
+    }
+
+    // Header id of any version
+    static bool Identifies(const uint32_t headerId)
+    {
+        return (headerId & 0xff00ffff) == (LZOHeaderId & 0xff00ffff) &&
+               LZOHash::Known((LZOHash::Checksum)((headerId >> 16) & 0xff));
+    }
+
     static size_t Size(const size_t additional = 0)
     {
         return sizeof(LZOHeader) + additional;
@@ -84,6 +106,16 @@ public:
         return lzo_crc32(0, (const lzo_bytep)header, sizeof(LZOHeader) - sizeof(uint32_t));
     }
 
+    // Hash of first and second data from their hashes (lzo_adler32 started with 0)
+    static uint32_t Adler32Combine(const uint32_t first, const uint32_t second, const uint64_t secondSize)
+    {
+        constexpr uint32_t base{65521};
+        const uint64_t     sum1{(first & 0xffff) + (second & 0xffff)};
+        const uint64_t     sum2{(first >> 16) + (second >> 16) + (secondSize % base) * (first & 0xffff)};
+
+        return (uint32_t)(sum1 % base) | ((uint32_t)(sum2 % base) << 16);
+    }
+
     uint32_t      HeaderId{LZOHeaderId};
     LZOFormat::Id FormatId{};
     uint32_t      SourceSize{};
@@ -92,3 +124,147 @@ public:
     uint32_t      DestinationHash{};
     uint32_t      HeaderHash{};
 };
+
+// Header with 64 bit sizes.
+// With FormatId Stream it is the trailer of a block stream without data of its own: SourceSize is the size of all
+// preceding blocks (headers included), DestinationSize the size of all decompressed data and the hashes are the
+// hashes of all compressed/ decompressed data (built by Append). With FlagIndex an index (FormatId Index, stored
+// LZOIndexEntry data) follows the blocks at SourceSize, with FlagDirectory the directory of an archive (FormatId
+// Directory, stored LZOArchiveEntry data each followed by the name of the member). FlagOptimized records that the
+// compressed data of the blocks was rewritten by the optimizer of their format for faster decompression.
+// The blocks of a block stream have this header (DictionaryId 0 or the Id of the preset dictionary, see LZODictionary),
+// so a block stream cut after any block is detected by its missing trailer.
+class LZOHeader64
+{
+public:
+    static constexpr uint32_t FlagIndex{0x00000001};
+    static constexpr uint32_t FlagDirectory{0x00000002};
+    static constexpr uint32_t FlagOptimized{0x00000004};
+
+    void Initialize(const LZOFormat::Id formatId, const uint64_t sourceSize, const uint64_t destinationSize,
+        const uint32_t sourceHash = {}, const uint32_t destinationHash = {}, const uint32_t flags = {},
+        const LZOHash::Checksum checksum = LZOHash::Checksum::Adler32)
+    {
+        HeaderId        = LZOHeaderVersion(sizeof(LZOHeader64), checksum);
+        FormatId        = formatId;
+        SourceSize      = sourceSize;
+        DestinationSize = destinationSize;
+        SourceHash      = sourceHash;
+        DestinationHash = destinationHash;
+        Flags           = flags;
+        HeaderHash      = HeaderCrc32(this, sizeof(*this));
+    }
+
+    // Adds a block to the stream sizes and hashes, Adler-32 hashes are combined to the hashes of all data, other
+    // checksums hash the previous hash and the hash of the block
+    template <typename Header>
+    void Append(const Header* header)
+    {
+        if (header->Checksum() == LZOHash::Checksum::Adler32)
+        {
+            SourceHash = LZOHeader::Adler32Combine(SourceHash, header->SourceHash, header->SourceSize);
+            DestinationHash =
+                LZOHeader::Adler32Combine(DestinationHash, header->DestinationHash, header->DestinationSize);
+        }
+        else
+        {
+            const uint32_t sourceHashes[]{SourceHash, header->SourceHash};
+            const uint32_t destinationHashes[]{DestinationHash, header->DestinationHash};
+
+            SourceHash = LZOHash::Hash(header->Checksum(), (const byte*)sourceHashes, sizeof(sourceHashes));
+            DestinationHash =
+                LZOHash::Hash(header->Checksum(), (const byte*)destinationHashes, sizeof(destinationHashes));
+        }
+        SourceSize += Header::Size(header->SourceSize);
+        DestinationSize += header->DestinationSize;
+    }
+
+    byte* Data() const
+    {
+        return (byte*)(this + 1);
+    }
+
+    bool Valid() const
+    {
+        return HeaderHash == HeaderCrc32(this, sizeof(*this));
+    }
+
+    // Checksum of the hashes (from the header id)
+    LZOHash::Checksum Checksum() const
+    {
+        return (LZOHash::Checksum)((HeaderId >> 16) & 0xff);
+    }
+
+    // Header id of any version
+    static bool Identifies(const uint32_t headerId)
+    {
+        return (headerId & 0xff00ffff) == (LZOHeader64Id & 0xff00ffff) &&
+               LZOHash::Known((LZOHash::Checksum)((headerId >> 16) & 0xff));
+    }
+
+    static size_t Size(const size_t additional = 0)
+    {
+        return sizeof(LZOHeader64) + additional;
+    }
+
+    static LZOHeader64* Header(const void* header, const size_t size, const bool check = false)
+    {
+        if (!header || size < sizeof(LZOHeader64) || !Identifies(((LZOHeader64*)header)->HeaderId))
+        {
+            return {};
+        }
+        if (check && ((LZOHeader64*)header)->HeaderHash != HeaderCrc32(header, size))
+        {
+            return {};
+        }
+
+        return (LZOHeader64*)header;
+    }
+
+    static uint32_t HeaderCrc32(const void* header, const size_t size)
+    {
+        if (!header || size < sizeof(LZOHeader64))
+        {
+            return {};
+        }
+
+        return lzo_crc32(0, (const lzo_bytep)header, sizeof(LZOHeader64) - sizeof(uint32_t));
+    }
+
+    uint32_t      HeaderId{LZOHeader64Id};
+    LZOFormat::Id FormatId{};
+    uint64_t      SourceSize{};
+    uint64_t      DestinationSize{};
+    uint32_t      SourceHash{};
+    uint32_t      DestinationHash{};
+    union
+    {
+        uint32_t Flags{};      // Flags of a trailer
+        uint32_t DictionaryId; // Dictionary of a block (0: none)
+    };
+    uint32_t HeaderHash{};
+};
+
+// Entry of a block stream index
+struct LZOIndexEntry
+{
+    uint64_t Offset{};          // Offset of the block header in the stream
+    uint64_t SourceSize{};      // Size of the block (header included)
+    uint64_t DestinationSize{}; // Size of the decompressed data
+};
+
+// Entry of an archive directory, the member is a block stream (without trailer) at Offset
+struct LZOArchiveEntry
+{
+    uint64_t      Offset{};          // Offset of the first block header of the member in the archive
+    uint64_t      SourceSize{};      // Size of the member blocks (headers included)
+    uint64_t      DestinationSize{}; // Size of the decompressed member
+    uint32_t      SourceHash{};      // Hash of the compressed member (as in a trailer)
+    uint32_t      DestinationHash{}; // Hash of the decompressed member (as in a trailer)
+    LZOFormat::Id FormatId{};        // Format of the member blocks
+    uint32_t      NameSize{};        // Size of the name (UTF-8) following the entry
+};
+
+static_assert(sizeof(LZOHeader) == 28 && sizeof(LZOHeader64) == 40, "Header size is part of HeaderId");
+static_assert(sizeof(LZOIndexEntry) == 24, "Index entry size is part of the format");
+static_assert(sizeof(LZOArchiveEntry) == 40, "Archive entry size is part of the format");
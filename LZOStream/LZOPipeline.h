@@ -0,0 +1,251 @@
+/* LZOStream\LZOPipeline.h -- ordered worker pipeline
+
+   This file is part of the LZOStream application for compressing/ decompressing files or streams.
+
+   Copyright (C) 2024 G DATA CyberDefense AG
+   All Rights Reserved.
+
+   The LZOStream application is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZOStream application is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZOStream application; see the file License.txt.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   G DATA CyberDefense AG
+   <source@gdata.de>
+   https://www.gdata.de/
+*/
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Processes jobs on worker threads and completes them in the order they were pushed.
+// With a single thread jobs are processed and completed directly in Push, overlapped they are processed on a worker
+// and completed on the writer thread while the next job is prepared. At most threads * 2 jobs are in flight, so
+// recycled jobs (Acquire) keep the memory fixed. An exception of process or complete (e.g. a failed allocation) is
+// the error not_enough_memory of the job.
+template <typename Job>
+class LZOPipeline
+{
+public:
+    using Process  = std::function<std::errc(Job& job, const size_t worker)>;
+    using Complete = std::function<std::errc(Job& job)>;
+
+    LZOPipeline(const size_t threads, Process process, Complete complete, const bool overlapped = false)
+        : _process(std::move(process))
+        , _complete(std::move(complete))
+        , _limit(threads * 2)
+    {
+        if (threads > 1 || overlapped)
+        {
+            try
+            {
+                for (size_t worker = 0; worker < threads; ++worker)
+                {
+                    _workers.emplace_back(&LZOPipeline::Work, this, worker);
+                }
+
+                _writer = std::thread(&LZOPipeline::Write, this);
+            }
+            catch (std::exception&)
+            {
+                // The threads already started are joined before the pipeline is destroyed
+                Finish();
+                throw;
+            }
+        }
+    }
+    LZOPipeline(const LZOPipeline&) = delete;
+    LZOPipeline& operator=(const LZOPipeline&) = delete;
+    ~LZOPipeline()
+    {
+        Finish();
+    }
+
+    // Returns a completed job for reuse (keeps its buffers) or a new one
+    Job Acquire()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_free.empty())
+        {
+            return {};
+        }
+
+        auto job{std::move(_free.back())};
+
+        _free.pop_back();
+
+        return job;
+    }
+
+    // Queues a job, blocks while too many jobs are in flight
+    std::errc Push(Job&& job)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        if (_workers.empty())
+        {
+            if (_error == std::errc{})
+            {
+                _error = Run([&]() { return _process(job, 0); });
+            }
+            if (_error == std::errc{})
+            {
+                _error = Run([&]() { return _complete(job); });
+            }
+
+            _free.push_back(std::move(job));
+
+            return _error;
+        }
+
+        _changed.wait(lock, [&]() { return _pushed - _completed < _limit || _error != std::errc{}; });
+
+        if (_error == std::errc{})
+        {
+            _queue.emplace_back(_pushed++, std::move(job));
+            _changed.notify_all();
+        }
+
+        return _error;
+    }
+
+    // Waits for all pushed jobs, returns the first error
+    std::errc Finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            _finished = true;
+            _changed.notify_all();
+        }
+
+        for (auto& worker : _workers)
+        {
+            if (worker.joinable())
+            {
+                worker.join();
+            }
+        }
+        if (_writer.joinable())
+        {
+            _writer.join();
+        }
+
+        return _error;
+    }
+
+private:
+    template <typename Function>
+    static std::errc Run(Function function)
+    {
+        try
+        {
+            return function();
+        }
+        catch (std::exception&)
+        {
+            return std::errc::not_enough_memory;
+        }
+    }
+
+    void Work(const size_t worker)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        for (;;)
+        {
+            _changed.wait(lock, [&]() { return !_queue.empty() || _finished || _error != std::errc{}; });
+
+            if (_queue.empty() || _error != std::errc{})
+            {
+                return;
+            }
+
+            auto entry{std::move(_queue.front())};
+
+            _queue.pop_front();
+            lock.unlock();
+
+            const auto error{Run([&]() { return _process(entry.second, worker); })};
+
+            lock.lock();
+
+            if (error != std::errc{} && _error == std::errc{})
+            {
+                _error = error;
+            }
+
+            _done.emplace(entry.first, std::move(entry.second));
+            _changed.notify_all();
+        }
+    }
+
+    void Write()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        for (;;)
+        {
+            _changed.wait(lock, [&]() {
+                return _done.count(_completed) || _error != std::errc{} || (_finished && _completed == _pushed);
+            });
+
+            if (!_done.count(_completed) || _error != std::errc{})
+            {
+                return;
+            }
+
+            auto job{std::move(_done[_completed])};
+
+            _done.erase(_completed);
+            lock.unlock();
+
+            const auto error{Run([&]() { return _complete(job); })};
+
+            lock.lock();
+
+            if (error != std::errc{} && _error == std::errc{})
+            {
+                _error = error;
+            }
+
+            _free.push_back(std::move(job));
+            ++_completed;
+            _changed.notify_all();
+        }
+    }
+
+    Process                            _process;
+    Complete                           _complete;
+    size_t                             _limit{};
+    std::vector<std::thread>           _workers;
+    std::thread                        _writer;
+    std::mutex                         _mutex;
+    std::condition_variable            _changed;
+    std::deque<std::pair<size_t, Job>> _queue;
+    std::map<size_t, Job>              _done;
+    std::vector<Job>                   _free;
+    size_t                             _pushed{};
+    size_t                             _completed{};
+    bool                               _finished{};
+    std::errc                          _error{};
+};
@@ -28,6 +28,7 @@
 #pragma once
 
 #include <atlbase.h>
+#include <psapi.h>
 #include "lzo/lzoconf.h"
 #include "lzo/lzo1.h"
 #include "lzo/lzo1a.h"
@@ -38,6 +39,9 @@
 #include "lzo/lzo1y.h"
 #include "lzo/lzo1z.h"
 #include "lzo/lzo2a.h"
+#ifdef _M_IX86
+#include "lzo/lzo_asm.h"
+#endif
 #pragma comment(lib, "lzo2.lib")
 #include <ostream>
 #include <string>
@@ -47,8 +51,10 @@ namespace std
 {
 #ifdef _UNICODE
 constexpr wostream& tcout = wcout;
+constexpr wostream& tcerr = wcerr;
 #else
 constexpr ostream& tcout = cout;
+constexpr ostream& tcerr = cerr;
 #endif
 using tstringstream = basic_stringstream<TCHAR, char_traits<TCHAR>, allocator<TCHAR>>;
 using tstring       = basic_string<TCHAR>;
@@ -0,0 +1,120 @@
+/* LZOStreamTest\CodecTest.cpp -- LZOCodec library tests
+
+   This file is part of the LZOStream application for compressing/ decompressing files or streams.
+
+   Copyright (C) 2024 G DATA CyberDefense AG
+   All Rights Reserved.
+
+   The LZOStream application is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZOStream application is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZOStream application; see the file License.txt.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   G DATA CyberDefense AG
+   <source@gdata.de>
+   https://www.gdata.de/
+*/
+
+#include "stdafx.h"
+#include "../LZOCodec/LZOCodecApi.h"
+#include <vector>
+
+TEST(Codec, Compress)
+{
+    std::string text;
+
+    while (text.size() < 256 * 1024)
+    {
+        text += "Lorem ipsum dolor sit amet, consectetur adipisici elit, sed eiusmod tempor incidunt ut labore. ";
+    }
+
+    std::vector<uint8_t> work(LZOCodecWorkSize(0));
+    std::vector<uint8_t> block(LZOCodecBound(text.size()));
+    std::vector<uint8_t> decompressed(text.size());
+
+    for (const auto& name : {"Lzo1x_1", "Lzo1x_999", "Lzo1b_9", "Lzo2a_999"})
+    {
+        const auto format{LZOCodecFormat(name)};
+        size_t     blockSize{block.size()};
+        size_t     decompressedSize{decompressed.size()};
+        uint64_t   size{};
+
+        EXPECT_TRUE(format != 0);
+        EXPECT_TRUE(LZOCodecWorkSize(format) <= work.size());
+        EXPECT_TRUE(LZOCodecCompress(format, text.data(), text.size(), block.data(), &blockSize, work.data()) ==
+                    LZOCODEC_OK);
+        EXPECT_TRUE(blockSize < text.size());
+        EXPECT_TRUE(LZOCodecSize(block.data(), blockSize, &size) == LZOCODEC_OK && size == text.size());
+        EXPECT_TRUE(LZOCodecVerify(block.data(), blockSize) == LZOCODEC_OK);
+        EXPECT_TRUE(LZOCodecDecompress(block.data(), blockSize, decompressed.data(), &decompressedSize,
+                        work.data()) == LZOCODEC_OK);
+        EXPECT_TRUE(decompressedSize == text.size());
+        EXPECT_TRUE(memcmp(text.data(), decompressed.data(), decompressedSize) == 0);
+    }
+}
+
+TEST(Codec, Errors)
+{
+    const std::string    text{"Lorem ipsum dolor sit amet, Lorem ipsum dolor sit amet, Lorem ipsum dolor sit amet"};
+    const auto           format{LZOCodecFormat("Lzo1x_1")};
+    std::vector<uint8_t> work(LZOCodecWorkSize(format));
+    std::vector<uint8_t> block(LZOCodecBound(text.size()));
+    std::vector<uint8_t> decompressed(text.size());
+    size_t               blockSize{text.size()};
+    size_t               decompressedSize{text.size() / 2};
+
+    EXPECT_TRUE(LZOCodecFormat("Unknown") == 0);
+    EXPECT_TRUE(LZOCodecCompress(0, text.data(), text.size(), block.data(), &blockSize, work.data()) ==
+                LZOCODEC_ERROR_ARGUMENT);
+    EXPECT_TRUE(LZOCodecCompress(format, text.data(), text.size(), block.data(), &blockSize, work.data()) ==
+                LZOCODEC_ERROR_BUFFER);
+
+    blockSize = block.size();
+
+    EXPECT_TRUE(LZOCodecCompress(format, text.data(), text.size(), block.data(), &blockSize, work.data()) ==
+                LZOCODEC_OK);
+    EXPECT_TRUE(LZOCodecDecompress(block.data(), blockSize, decompressed.data(), &decompressedSize, work.data()) ==
+                LZOCODEC_ERROR_BUFFER);
+    EXPECT_TRUE(LZOCodecVerify(block.data(), blockSize - 1) == LZOCODEC_ERROR_DATA);
+
+    block[blockSize - 1] ^= 0xff;
+    decompressedSize = decompressed.size();
+
+    EXPECT_TRUE(LZOCodecVerify(block.data(), blockSize) == LZOCODEC_ERROR_DATA);
+    EXPECT_TRUE(LZOCodecDecompress(block.data(), blockSize, decompressed.data(), &decompressedSize, work.data()) ==
+                LZOCODEC_ERROR_DATA);
+}
+
+TEST(Codec, Safe)
+{
+    std::string text;
+
+    while (text.size() < 64 * 1024)
+    {
+        text += "Lorem ipsum dolor sit amet, consectetur adipisici elit, sed eiusmod tempor incidunt ut labore. ";
+    }
+
+    const auto           format{LZOCodecFormat("Lzo1")};
+    std::vector<uint8_t> work(LZOCodecWorkSize(format));
+    std::vector<uint8_t> block(LZOCodecBound(text.size()));
+    std::vector<uint8_t> decompressed(text.size());
+    size_t               blockSize{block.size()};
+    size_t               decompressedSize{decompressed.size()};
+
+    // Lzo1 has no safe decompressor, the library does not decompress its blocks
+    EXPECT_TRUE(LZOCodecCompress(format, text.data(), text.size(), block.data(), &blockSize, work.data()) ==
+                LZOCODEC_OK);
+    EXPECT_TRUE(blockSize < text.size());
+    EXPECT_TRUE(LZOCodecDecompress(block.data(), blockSize, decompressed.data(), &decompressedSize, work.data()) ==
+                LZOCODEC_ERROR_DATA);
+}
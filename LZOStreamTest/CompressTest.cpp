@@ -45,6 +45,21 @@ const std::vector<LPCTSTR> Formats{_T("Lzo1"), _T("Lzo1_99"), _T("Lzo1a"), _T("L
     _T("Lzo1x_1_12"), _T("Lzo1x_1_15"), _T("Lzo1x_999"), _T("Lzo1y"), _T("Lzo1y_1"), _T("Lzo1y_999"), _T("Lzo1z"),
     _T("Lzo1z_999"), _T("Lzo2a"), _T("Lzo2a_999")};
 
+// Formats without a safe decompressor, their data is rejected when it is decompressed safe (stdin, headerless without
+// --decoder fast)
+bool Unsafe(LPCTSTR format)
+{
+    for (const auto& unsafe : {_T("Lzo1"), _T("Lzo1_99"), _T("Lzo1a"), _T("Lzo1a_99")})
+    {
+        if (_tcsicmp(format, unsafe) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool WriteData(LPCTSTR file, const void* data, const uint32_t size)
 {
     const auto handle{CreateFile(file, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)};
@@ -101,6 +116,46 @@ std::string ReadString(LPCTSTR file)
     return {};
 }
 
+// Lorem ipsum repeated to at least size bytes
+std::string Lorem(const size_t size)
+{
+    std::string lorem;
+
+    while (lorem.size() < size)
+    {
+        lorem += loremIpsum;
+    }
+
+    return lorem;
+}
+
+// Compresses inputFile (format, compress options) to a file, decompresses it (decompress options) and returns the
+// decompressed data, allocated gets the size the decompressed file takes on disk
+std::string RoundTrip(LPCTSTR lzoStream, const std::tstring& inputFile, LPCTSTR format, LPCTSTR compress,
+    LPCTSTR decompress, uint64_t* allocated = {})
+{
+    const auto compressedFile{_T("Compressed_") + inputFile + _T(".lzo")};
+    const auto decompressedFile{_T("Decompressed_") + inputFile};
+
+    EXPECT_TRUE(LZOStreamCompress(lzoStream, inputFile.data(), compressedFile.data(), format, compress));
+    EXPECT_TRUE(LZOStreamDecompress(lzoStream, compressedFile.data(), decompressedFile.data(), decompress));
+
+    const auto decompressed{ReadString(decompressedFile.data())};
+
+    if (allocated)
+    {
+        DWORD      high{};
+        const auto low{GetCompressedFileSize(decompressedFile.data(), &high)};
+
+        *allocated = (low == INVALID_FILE_SIZE) ? UINT64_MAX : ((uint64_t)high << 32) | low;
+    }
+
+    DeleteFile(compressedFile.data());
+    DeleteFile(decompressedFile.data());
+
+    return decompressed;
+}
+
 TEST(Compress, Basic)
 {
     const auto lzoStream{_T(R"(LZOStream.exe)")};
@@ -108,8 +163,13 @@ TEST(Compress, Basic)
     for (const auto& format : Formats)
     {
         const auto compressed{LZOStreamCompress(lzoStream, loremIpsum.data(), loremIpsum.size(), format)};
-        const auto decompressed{LZOStreamDecompress(lzoStream, compressed.data(), compressed.size())};
+        const auto arguments{(Unsafe(format)) ? _T("d --decoder fast") : _T("d")};
+        const auto decompressed{LZOStreamCall(lzoStream, arguments, compressed.data(), compressed.size())};
 
+        if (Unsafe(format))
+        {
+            EXPECT_TRUE(LZOStreamDecompress(lzoStream, compressed.data(), compressed.size()).empty());
+        }
         EXPECT_TRUE(loremIpsum.size() >= compressed.size());
         EXPECT_TRUE(loremIpsum.size() == decompressed.size());
         EXPECT_TRUE(memcmp(loremIpsum.data(), decompressed.data(), decompressed.size()) == 0);
@@ -123,8 +183,9 @@ TEST(Compress, Headerless)
     for (const auto& format : Formats)
     {
         const auto compressed{LZOStreamCompress(lzoStream, loremIpsum.data(), loremIpsum.size(), format, true, true)};
-        const auto decompressed{
-            LZOStreamDecompress(lzoStream, compressed.data(), compressed.size(), true, format, loremIpsum.size())};
+        const auto decoder{(Unsafe(format)) ? _T("fast") : nullptr};
+        const auto decompressed{LZOStreamDecompress(
+            lzoStream, compressed.data(), compressed.size(), true, format, loremIpsum.size(), 0, decoder)};
 
         EXPECT_TRUE(loremIpsum.size() >= compressed.size());
         EXPECT_TRUE(loremIpsum.size() == decompressed.size());
@@ -142,8 +203,27 @@ TEST(Compress, Large)
     for (const auto& format : Formats)
     {
         const auto compressed{LZOStreamCompress(lzoStream, large.data(), large.size(), format, true, true)};
-        const auto decompressed{
-            LZOStreamDecompress(lzoStream, compressed.data(), compressed.size(), true, format, large.size())};
+        const auto decoder{(Unsafe(format)) ? _T("fast") : nullptr};
+        const auto decompressed{LZOStreamDecompress(
+            lzoStream, compressed.data(), compressed.size(), true, format, large.size(), 0, decoder)};
+
+        EXPECT_TRUE(large.size() >= compressed.size());
+        EXPECT_TRUE(large.size() == decompressed.size());
+        EXPECT_TRUE(memcmp(large.data(), decompressed.data(), decompressed.size()) == 0);
+    }
+}
+
+TEST(Compress, Block)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto large{Lorem(1024 * 1024)};
+
+    for (const auto& format : Formats)
+    {
+        const auto compressed{
+            LZOStreamCompress(lzoStream, large.data(), large.size(), format, false, false, 256 * 1024)};
+        const auto arguments{(Unsafe(format)) ? _T("d --decoder fast") : _T("d")};
+        const auto decompressed{LZOStreamCall(lzoStream, arguments, compressed.data(), compressed.size())};
 
         EXPECT_TRUE(large.size() >= compressed.size());
         EXPECT_TRUE(large.size() == decompressed.size());
@@ -151,6 +231,52 @@ TEST(Compress, Large)
     }
 }
 
+TEST(Compress, Threads)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto large{Lorem(4 * 1024 * 1024)};
+
+    const auto single{LZOStreamCompress(lzoStream, large.data(), large.size(), _T("Lzo1x_999"), false, false, 0, 1)};
+    const auto multiple{
+        LZOStreamCompress(lzoStream, large.data(), large.size(), _T("Lzo1x_999"), false, false, 256 * 1024, 8)};
+    const auto decompressed{LZOStreamDecompress(lzoStream, multiple.data(), multiple.size(), false, {}, 0, 8)};
+
+    EXPECT_TRUE(single.size() < large.size());
+    EXPECT_TRUE(large.size() == decompressed.size());
+    EXPECT_TRUE(memcmp(large.data(), decompressed.data(), decompressed.size()) == 0);
+    EXPECT_TRUE(
+        single == LZOStreamCompress(lzoStream, large.data(), large.size(), _T("Lzo1x_999"), false, false, 0, 4));
+    EXPECT_TRUE(multiple ==
+                LZOStreamCompress(lzoStream, large.data(), large.size(), _T("Lzo1x_999"), false, false, 256 * 1024, 1));
+}
+
+TEST(Compress, Info)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto large{Lorem(1024 * 1024)};
+
+    // Piped input has no known size and is always compressed as blocks, a file of known size gets a single header
+    const auto appendix{std::to_tstring(GetCurrentProcessId()) + _T("_") + std::to_tstring(GetCurrentThreadId())};
+    const auto inputFile{std::tstring(_T("Input_")) + appendix + _T(".txt")};
+    const auto compressedFile{std::tstring(_T("Compressed_")) + appendix + _T(".lzo")};
+
+    EXPECT_TRUE(WriteData(inputFile.data(), large.data(), large.size()));
+    EXPECT_TRUE(LZOStreamCompress(lzoStream, inputFile.data(), compressedFile.data()));
+
+    const auto single{ReadString(compressedFile.data())};
+    const auto blocks{
+        LZOStreamCompress(lzoStream, large.data(), large.size(), _T("Lzo1x_1"), false, false, 256 * 1024)};
+    const auto singleInfo{LZOStreamCall(lzoStream, _T("i"), single.data(), single.size())};
+
+    DeleteFile(inputFile.data());
+    DeleteFile(compressedFile.data());
+    const auto blocksInfo{LZOStreamCall(lzoStream, _T("i"), blocks.data(), blocks.size())};
+
+    EXPECT_TRUE(std::string(singleInfo.begin(), singleInfo.end()).find("Trailer") == std::string::npos);
+    EXPECT_TRUE(std::string(blocksInfo.begin(), blocksInfo.end()).find("Trailer") != std::string::npos);
+    EXPECT_TRUE(std::string(blocksInfo.begin(), blocksInfo.end()).find("Stream") != std::string::npos);
+}
+
 TEST(Compress, File)
 {
     const auto lzoStream{_T("LZOStream.exe")};
@@ -177,3 +303,581 @@ TEST(Compress, File)
 
     DeleteFile(inputFile.data());
 }
+
+TEST(Compress, Mapped)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto appendix{std::to_tstring(GetCurrentProcessId()) + _T("_") + std::to_tstring(GetCurrentThreadId())};
+    const auto inputFile{std::tstring(_T("Input_")) + appendix + _T(".txt")};
+    const auto large{Lorem(1024 * 1024)};
+
+    EXPECT_TRUE(WriteData(inputFile.data(), large.data(), large.size()));
+
+    for (const auto& options : {_T("-m"), _T("-m -b 256k -t 4")})
+    {
+        const auto compressedFile{std::tstring(_T("Compressed_")) + appendix + _T(".lzo")};
+        const auto decompressedFile{std::tstring(_T("Decompressed_")) + appendix + _T(".txt")};
+
+        EXPECT_TRUE(LZOStreamCompress(lzoStream, inputFile.data(), compressedFile.data(), _T("Lzo1x_1"), options));
+        EXPECT_TRUE(LZOStreamDecompress(lzoStream, compressedFile.data(), decompressedFile.data(), options));
+
+        const auto decompressed{ReadString(decompressedFile.data())};
+
+        DeleteFile(compressedFile.data());
+        DeleteFile(decompressedFile.data());
+
+        EXPECT_TRUE(large == decompressed);
+    }
+
+    DeleteFile(inputFile.data());
+}
+
+TEST(Compress, Extract)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto appendix{std::to_tstring(GetCurrentProcessId()) + _T("_") + std::to_tstring(GetCurrentThreadId())};
+    const auto inputFile{std::tstring(_T("Input_")) + appendix + _T(".txt")};
+    const auto compressedFile{std::tstring(_T("Compressed_")) + appendix + _T(".lzo")};
+    const auto large{Lorem(1024 * 1024)};
+
+    EXPECT_TRUE(WriteData(inputFile.data(), large.data(), large.size()));
+    EXPECT_TRUE(LZOStreamCompress(lzoStream, inputFile.data(), compressedFile.data(), _T("Lzo1x_1"), _T("-b 256k -x")));
+
+    const auto compressed{ReadString(compressedFile.data())};
+
+    for (const auto& range : {std::make_pair(0, 100), std::make_pair(262000, 1000), std::make_pair(300000, 700000)})
+    {
+        const auto options{_T(" -s ") + std::to_tstring(range.first) + _T(" -n ") + std::to_tstring(range.second)};
+        const auto indexed{LZOStreamCall(lzoStream, (_T("x -i ") + compressedFile + options).data(), nullptr, 0)};
+        const auto streamed{
+            LZOStreamCall(lzoStream, (_T("x") + options).data(), compressed.data(), compressed.size())};
+
+        EXPECT_TRUE(large.substr(range.first, range.second) == std::string(indexed.begin(), indexed.end()));
+        EXPECT_TRUE(large.substr(range.first, range.second) == std::string(streamed.begin(), streamed.end()));
+    }
+
+    const auto info{LZOStreamCall(lzoStream, (_T("i -i ") + compressedFile).data(), nullptr, 0)};
+
+    EXPECT_TRUE(std::string(info.begin(), info.end()).find("Index at") != std::string::npos);
+
+    DeleteFile(compressedFile.data());
+    DeleteFile(inputFile.data());
+}
+
+TEST(Compress, LargePages)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto appendix{std::to_tstring(GetCurrentProcessId()) + _T("_") + std::to_tstring(GetCurrentThreadId())};
+    const auto inputFile{std::tstring(_T("Input_")) + appendix + _T(".txt")};
+    const auto compressedFile{std::tstring(_T("Compressed_")) + appendix + _T(".lzo")};
+    const auto decompressedFile{std::tstring(_T("Decompressed_")) + appendix + _T(".txt")};
+    const auto large{Lorem(4 * 1024 * 1024)};
+
+    // Without the privilege to lock pages in memory normal pages are used
+    EXPECT_TRUE(WriteData(inputFile.data(), large.data(), large.size()));
+    EXPECT_TRUE(LZOStreamCompress(lzoStream, inputFile.data(), compressedFile.data(), _T("Lzo1x_1"), _T("-p -t 2")));
+    EXPECT_TRUE(LZOStreamDecompress(lzoStream, compressedFile.data(), decompressedFile.data(), _T("-p -t 2")));
+    EXPECT_TRUE(large == ReadString(decompressedFile.data()));
+
+    DeleteFile(decompressedFile.data());
+    DeleteFile(compressedFile.data());
+    DeleteFile(inputFile.data());
+}
+
+TEST(Compress, Bench)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto table{LZOStreamCall(lzoStream, _T("b -r 1"), loremIpsum.data(), loremIpsum.size())};
+    const auto csv{
+        LZOStreamCall(lzoStream, _T("b -f Lzo1x_1,Lzo2a -r 1 -e csv"), loremIpsum.data(), loremIpsum.size())};
+    const auto tableText{std::string(table.begin(), table.end())};
+    const auto csvText{std::string(csv.begin(), csv.end())};
+
+    for (const auto& format : {"Lzo1", "Lzo1b_9", "Lzo1x_999", "Lzo2a_999"})
+    {
+        EXPECT_TRUE(tableText.find(format) != std::string::npos);
+    }
+    EXPECT_TRUE(tableText.find("(error)") == std::string::npos);
+    EXPECT_TRUE(csvText.find("Format,CompressMBs") == 0);
+    EXPECT_TRUE(csvText.find("\nLzo1x_1,") != std::string::npos);
+    EXPECT_TRUE(csvText.find("\nLzo2a,") != std::string::npos);
+    EXPECT_TRUE(csvText.find("Lzo1b") == std::string::npos);
+}
+
+TEST(Compress, Auto)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto large{Lorem(1024 * 1024)};
+
+    for (const auto& arguments : {_T("c -f auto"), _T("c -f auto --target-speed 1"), _T("c -f auto --target-ratio 50"),
+             _T("c -f auto -b 256k -t 2")})
+    {
+        const auto compressed{LZOStreamCall(lzoStream, arguments, large.data(), large.size())};
+        const auto decompressed{LZOStreamDecompress(lzoStream, compressed.data(), compressed.size())};
+
+        EXPECT_TRUE(compressed.size() < large.size());
+        EXPECT_TRUE(large.size() == decompressed.size());
+        EXPECT_TRUE(memcmp(large.data(), decompressed.data(), decompressed.size()) == 0);
+    }
+
+    EXPECT_TRUE(LZOStreamCall(lzoStream, _T("c -f auto -h"), large.data(), large.size()).size() < 100);
+}
+
+TEST(Compress, Stored)
+{
+    const auto   lzoStream{_T("LZOStream.exe")};
+    std::mt19937 random;
+    std::string  noise;
+    std::string  mixed;
+
+    while (noise.size() < 1024 * 1024)
+    {
+        noise += (char)random();
+    }
+    while (mixed.size() < 1024 * 1024)
+    {
+        mixed += loremIpsum;
+    }
+    mixed += noise;
+
+    const auto compressed{LZOStreamCall(lzoStream, _T("c -f Lzo1x_999 -b 256k"), noise.data(), noise.size())};
+    const auto decompressed{LZOStreamDecompress(lzoStream, compressed.data(), compressed.size())};
+
+    EXPECT_TRUE(compressed.size() == noise.size() + 4 * 28 + 40);
+    EXPECT_TRUE(noise.size() == decompressed.size());
+    EXPECT_TRUE(memcmp(noise.data(), decompressed.data(), decompressed.size()) == 0);
+
+    const auto compressedMixed{LZOStreamCall(lzoStream, _T("c -b 256k -t 2"), mixed.data(), mixed.size())};
+    const auto decompressedMixed{LZOStreamDecompress(lzoStream, compressedMixed.data(), compressedMixed.size())};
+
+    EXPECT_TRUE(compressedMixed.size() < noise.size() + 256 * 1024);
+    EXPECT_TRUE(mixed.size() == decompressedMixed.size());
+    EXPECT_TRUE(memcmp(mixed.data(), decompressedMixed.data(), decompressedMixed.size()) == 0);
+
+    // A dense prefix does not store a compressible block
+    const auto prefixed{noise.substr(0, 64 * 1024) + mixed.substr(0, 1024 * 1024)};
+    const auto compressedPrefixed{LZOStreamCall(lzoStream, _T("c"), prefixed.data(), prefixed.size())};
+
+    EXPECT_TRUE(compressedPrefixed.size() < prefixed.size() / 2);
+}
+
+TEST(Compress, BenchHash)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto table{LZOStreamCall(lzoStream, _T("b -a -r 1"), loremIpsum.data(), loremIpsum.size())};
+    const auto csv{LZOStreamCall(lzoStream, _T("b --hash -r 1 -e csv"), loremIpsum.data(), loremIpsum.size())};
+    const auto tableText{std::string(table.begin(), table.end())};
+    const auto csvText{std::string(csv.begin(), csv.end())};
+
+    EXPECT_TRUE(tableText.find("Adler32_Scalar") != std::string::npos);
+    EXPECT_TRUE(tableText.find("(error)") == std::string::npos);
+    EXPECT_TRUE(csvText.find("Hash,MBs") == 0);
+    EXPECT_TRUE(csvText.find("\nAdler32_Scalar,") != std::string::npos);
+}
+
+TEST(Compress, Checksum)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto large{Lorem(1024 * 1024)};
+
+    for (const auto& arguments : {_T("c -k adler32"), _T("c -k crc32c"), _T("c -k xxh64 -b 256k -t 2 -x"),
+             _T("c -k none -b 256k")})
+    {
+        auto       compressed{LZOStreamCall(lzoStream, arguments, large.data(), large.size())};
+        const auto decompressed{LZOStreamDecompress(lzoStream, compressed.data(), compressed.size())};
+
+        EXPECT_TRUE(compressed.size() > 4 && compressed[0] == 'L' && compressed[1] == 'Z');
+        EXPECT_TRUE(large.size() == decompressed.size());
+        EXPECT_TRUE(memcmp(large.data(), decompressed.data(), decompressed.size()) == 0);
+
+        if (compressed[2] != 'N')
+        {
+            compressed[compressed.size() / 2] ^= 0x55;
+            EXPECT_TRUE(LZOStreamDecompress(lzoStream, compressed.data(), compressed.size()).size() < large.size());
+        }
+    }
+}
+
+TEST(Compress, Stream)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto large{Lorem(1024 * 1024)};
+
+    for (const auto& arguments : {_T("c -w"), _T("c -w -b 256k"), _T("c -w -b 256k -t 2")})
+    {
+        const auto compressed{LZOStreamCall(lzoStream, arguments, large.data(), large.size())};
+        const auto decompressed{LZOStreamCall(lzoStream, _T("d -w"), compressed.data(), compressed.size())};
+        const auto info{LZOStreamCall(lzoStream, _T("i"), compressed.data(), compressed.size())};
+
+        EXPECT_TRUE(std::string(info.begin(), info.end()).find("Trailer") != std::string::npos);
+        EXPECT_TRUE(large.size() == decompressed.size());
+        EXPECT_TRUE(memcmp(large.data(), decompressed.data(), decompressed.size()) == 0);
+    }
+
+    EXPECT_TRUE(LZOStreamCall(lzoStream, _T("c -w -h"), large.data(), large.size()).size() < 100);
+}
+
+TEST(Compress, Batch)
+{
+    const auto  lzoStream{_T("LZOStream.exe")};
+    const auto  appendix{std::to_string(GetCurrentProcessId()) + "_" + std::to_string(GetCurrentThreadId())};
+    std::string list;
+    std::string compressedList;
+
+    for (size_t file{}; file < 3; ++file)
+    {
+        const auto name{"Batch_" + appendix + "_" + std::to_string(file) + ".txt"};
+
+        EXPECT_TRUE(WriteData(CA2T(name.data()), loremIpsum.data(), loremIpsum.size() / (file + 1)));
+        list += name + "\r\n";
+        compressedList += name + ".lzo\n";
+    }
+
+    const auto compressed{LZOStreamCall(lzoStream, _T("c --batch -t 2"), list.data(), list.size())};
+
+    for (size_t file{}; file < 3; ++file)
+    {
+        DeleteFile(CA2T(("Batch_" + appendix + "_" + std::to_string(file) + ".txt").data()));
+    }
+
+    const auto decompressed{LZOStreamCall(lzoStream, _T("d --batch"), compressedList.data(), compressedList.size())};
+
+    EXPECT_TRUE(std::string(compressed.begin(), compressed.end()).find("3 file(s), 0 failed") != std::string::npos);
+    EXPECT_TRUE(std::string(decompressed.begin(), decompressed.end()).find("3 file(s), 0 failed") != std::string::npos);
+
+    for (size_t file{}; file < 3; ++file)
+    {
+        const auto name{"Batch_" + appendix + "_" + std::to_string(file) + ".txt"};
+
+        EXPECT_TRUE(ReadString(CA2T(name.data())) == loremIpsum.substr(0, loremIpsum.size() / (file + 1)));
+        DeleteFile(CA2T(name.data()));
+        DeleteFile(CA2T((name + ".lzo").data()));
+    }
+
+    // Messages of files processed in parallel are written in list order behind their file
+    std::string missingList;
+
+    for (size_t file{}; file < 8; ++file)
+    {
+        missingList += "Missing_" + appendix + "_" + std::to_string(file) + ".txt\n";
+    }
+
+    const auto missing{LZOStreamCall(lzoStream, _T("c --batch -t 4"), missingList.data(), missingList.size())};
+    const auto missingText{std::string(missing.begin(), missing.end())};
+    size_t     position{};
+
+    for (size_t file{}; file < 8; ++file)
+    {
+        const auto name{"Missing_" + appendix + "_" + std::to_string(file) + ".txt"};
+        const auto failed{missingText.find("Failed " + name, position)};
+        const auto message{missingText.find("Error opening " + name, position)};
+
+        EXPECT_TRUE(failed != std::string::npos && message != std::string::npos && failed < message);
+        position = message;
+    }
+
+    // With -o files of different directories with the same name would overwrite each other, the later one fails
+    const auto  directories{std::vector<std::string>{"BatchA_" + appendix, "BatchB_" + appendix}};
+    const auto  outputDirectory{"BatchOutput_" + appendix};
+    std::string sameList;
+
+    for (const auto& directory : directories)
+    {
+        EXPECT_TRUE(CreateDirectory(CA2T(directory.data()), nullptr));
+        EXPECT_TRUE(WriteData(CA2T((directory + "\\Same.txt").data()), loremIpsum.data(), loremIpsum.size()));
+        sameList += directory + "\\Same.txt\n";
+    }
+
+    const auto arguments{_T("c --batch -t 2 -o ") + std::tstring(CA2T(outputDirectory.data()))};
+    const auto same{LZOStreamCall(lzoStream, arguments.data(), sameList.data(), sameList.size())};
+    const auto sameText{std::string(same.begin(), same.end())};
+    const auto output{ReadString(CA2T((outputDirectory + "\\Same.txt.lzo").data()))};
+
+    for (const auto& directory : directories)
+    {
+        DeleteFile(CA2T((directory + "\\Same.txt").data()));
+        RemoveDirectory(CA2T(directory.data()));
+    }
+    DeleteFile(CA2T((outputDirectory + "\\Same.txt.lzo").data()));
+    RemoveDirectory(CA2T(outputDirectory.data()));
+
+    EXPECT_TRUE(sameText.find("2 file(s), 1 failed") != std::string::npos);
+    EXPECT_TRUE(sameText.find("Failed " + directories[1] + "\\Same.txt") != std::string::npos);
+    EXPECT_TRUE(sameText.find("Duplicate output") != std::string::npos);
+    EXPECT_FALSE(output.empty());
+}
+
+TEST(Compress, Archive)
+{
+    const auto  lzoStream{_T("LZOStream.exe")};
+    const auto  appendix{std::to_string(GetCurrentProcessId()) + "_" + std::to_string(GetCurrentThreadId())};
+    const auto  archiveFile{_T("Archive_") + std::tstring(CA2T(appendix.data())) + _T(".lzo")};
+    std::string list;
+
+    for (size_t file{}; file < 3; ++file)
+    {
+        const auto name{"Member_" + appendix + "_" + std::to_string(file) + ".txt"};
+
+        EXPECT_TRUE(WriteData(CA2T(name.data()), loremIpsum.data(), loremIpsum.size() / (file + 1)));
+        list += name + "\n";
+    }
+
+    LZOStreamCall(lzoStream, (_T("a -t 2 -o ") + archiveFile).data(), list.data(), list.size());
+
+    const auto listed{LZOStreamCall(lzoStream, (_T("l -i ") + archiveFile).data(), nullptr, 0)};
+
+    EXPECT_TRUE(std::string(listed.begin(), listed.end()).find("3 member(s)") != std::string::npos);
+
+    for (size_t file{}; file < 3; ++file)
+    {
+        const auto name{"Member_" + appendix + "_" + std::to_string(file) + ".txt"};
+        const auto member{LZOStreamCall(lzoStream,
+            (_T("x --member ") + std::tstring(CA2T(name.data())) + _T(" -i ") + archiveFile).data(), nullptr, 0)};
+
+        EXPECT_TRUE(std::string(listed.begin(), listed.end()).find(name) != std::string::npos);
+        EXPECT_TRUE(std::string(member.begin(), member.end()) == loremIpsum.substr(0, loremIpsum.size() / (file + 1)));
+        DeleteFile(CA2T(name.data()));
+    }
+
+    DeleteFile(archiveFile.data());
+}
+
+TEST(Compress, Dictionary)
+{
+    const auto  lzoStream{_T("LZOStream.exe")};
+    const auto  appendix{std::to_string(GetCurrentProcessId()) + "_" + std::to_string(GetCurrentThreadId())};
+    const auto  dictionaryFile{_T("Dictionary_") + std::tstring(CA2T(appendix.data())) + _T(".dict")};
+    std::string list;
+
+    for (size_t file{}; file < 8; ++file)
+    {
+        const auto name{"Sample_" + appendix + "_" + std::to_string(file) + ".txt"};
+
+        EXPECT_TRUE(WriteData(CA2T(name.data()), loremIpsum.data() + file * 16, loremIpsum.size() - file * 16));
+        list += name + "\n";
+    }
+
+    LZOStreamCall(lzoStream, (_T("y -o ") + dictionaryFile).data(), list.data(), list.size());
+
+    for (size_t file{}; file < 8; ++file)
+    {
+        DeleteFile(CA2T(("Sample_" + appendix + "_" + std::to_string(file) + ".txt").data()));
+    }
+
+    const auto dictionary{_T(" --dict ") + dictionaryFile};
+    const auto compressed{
+        LZOStreamCall(lzoStream, (_T("c") + dictionary).data(), loremIpsum.data() + 100, loremIpsum.size() - 100)};
+    const auto decompressed{
+        LZOStreamCall(lzoStream, (_T("d") + dictionary).data(), compressed.data(), compressed.size())};
+    const auto missing{LZOStreamCall(lzoStream, _T("d"), compressed.data(), compressed.size())};
+
+    EXPECT_FALSE(ReadString(dictionaryFile.data()).empty());
+    EXPECT_TRUE(std::string(decompressed.begin(), decompressed.end()) == loremIpsum.substr(100));
+    EXPECT_TRUE(std::string(missing.begin(), missing.end()).find("Dictionary missing") != std::string::npos);
+
+    DeleteFile(dictionaryFile.data());
+}
+
+TEST(Compress, Level)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+
+    for (const auto& arguments : {_T("c --level 1"), _T("c -f Lzo1y_999 --level 5 -b 256k -t 2"), _T("c --level 9")})
+    {
+        const auto compressed{LZOStreamCall(lzoStream, arguments, loremIpsum.data(), loremIpsum.size())};
+        const auto decompressed{LZOStreamDecompress(lzoStream, compressed.data(), compressed.size())};
+
+        EXPECT_TRUE(std::string(decompressed.begin(), decompressed.end()) == loremIpsum);
+    }
+
+    const auto csv{LZOStreamCall(
+        lzoStream, _T("b -f Lzo1x_1,Lzo1x_999 --level 1,9 -r 1 -e csv"), loremIpsum.data(), loremIpsum.size())};
+    const auto csvText{std::string(csv.begin(), csv.end())};
+    const auto wrong{LZOStreamCall(lzoStream, _T("c -f Lzo1x_1 --level 1"), loremIpsum.data(), loremIpsum.size())};
+
+    EXPECT_TRUE(csvText.find(",Level\n") != std::string::npos);
+    EXPECT_TRUE(csvText.find("\nLzo1x_1,") != std::string::npos);
+    EXPECT_TRUE(csvText.find(",1\n") != std::string::npos);
+    EXPECT_TRUE(csvText.find(",9\n") != std::string::npos);
+    EXPECT_TRUE(std::string(wrong.begin(), wrong.end()).find("Level needs format") != std::string::npos);
+}
+
+TEST(Compress, Optimize)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+
+    for (const auto& arguments :
+        {_T("c --optimize"), _T("c -f Lzo1x_1 --optimize -b 256k -t 2"), _T("c -f Lzo1y --optimize")})
+    {
+        const auto compressed{LZOStreamCall(lzoStream, arguments, loremIpsum.data(), loremIpsum.size())};
+        const auto decompressed{LZOStreamDecompress(lzoStream, compressed.data(), compressed.size())};
+        const auto info{LZOStreamCall(lzoStream, _T("i"), compressed.data(), compressed.size())};
+
+        EXPECT_TRUE(std::string(decompressed.begin(), decompressed.end()) == loremIpsum);
+        EXPECT_TRUE(std::string(info.begin(), info.end()).find("Flags           : 0x00000004") != std::string::npos);
+    }
+
+    const auto table{
+        LZOStreamCall(lzoStream, _T("b -f Lzo1x_1,Lzo2a --optimize -r 1"), loremIpsum.data(), loremIpsum.size())};
+    const auto tableText{std::string(table.begin(), table.end())};
+    const auto wrong{LZOStreamCall(lzoStream, _T("c -f Lzo2a --optimize"), loremIpsum.data(), loremIpsum.size())};
+
+    EXPECT_TRUE(tableText.find("yes") != std::string::npos);
+    EXPECT_TRUE(tableText.find("(error)") == std::string::npos);
+    EXPECT_TRUE(std::string(wrong.begin(), wrong.end()).find("Optimize needs format") != std::string::npos);
+}
+
+TEST(Compress, Decoder)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+
+    for (const auto& format : {_T("c"), _T("c -f Lzo1c -b 256k"), _T("c -f Lzo2a -k none")})
+    {
+        const auto compressed{LZOStreamCall(lzoStream, format, loremIpsum.data(), loremIpsum.size())};
+
+        for (const auto& arguments : {_T("d --decoder safe"), _T("d --decoder fast"), _T("d --decoder asm")})
+        {
+            const auto decompressed{LZOStreamCall(lzoStream, arguments, compressed.data(), compressed.size())};
+
+            EXPECT_TRUE(std::string(decompressed.begin(), decompressed.end()) == loremIpsum);
+        }
+    }
+
+    const auto unknown{LZOStreamCall(lzoStream, _T("d --decoder turbo"), loremIpsum.data(), loremIpsum.size())};
+
+    EXPECT_TRUE(std::string(unknown.begin(), unknown.end()).find("Unknown decoder") != std::string::npos);
+}
+
+TEST(Compress, Test)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    auto       compressed{LZOStreamCall(lzoStream, _T("c -b 256k"), loremIpsum.data(), loremIpsum.size())};
+    const auto good{LZOStreamCall(lzoStream, _T("t"), compressed.data(), compressed.size())};
+    const auto goodText{std::string(good.begin(), good.end())};
+
+    compressed[compressed.size() / 2] ^= 0x55;
+
+    const auto bad{LZOStreamCall(lzoStream, _T("t"), compressed.data(), compressed.size())};
+    const auto badText{std::string(bad.begin(), bad.end())};
+
+    EXPECT_TRUE(goodText.find("Ok") != std::string::npos);
+    EXPECT_TRUE(goodText.find("Tested 1 file(s), 0 failed") != std::string::npos);
+    EXPECT_TRUE(badText.find("Failed") != std::string::npos);
+    EXPECT_TRUE(badText.find("Tested 1 file(s), 1 failed") != std::string::npos);
+}
+
+TEST(Compress, Truncated)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto large{Lorem(1024 * 1024)};
+
+    // The blocks of a stream have headers with 64 bit sizes (SourceSize at 0x08), a stream cut after its first block
+    // misses the trailer
+    const auto compressed{LZOStreamCall(lzoStream, _T("c -b 256k"), large.data(), large.size())};
+    uint64_t   sourceSize{};
+
+    memcpy(&sourceSize, compressed.data() + 8, sizeof(sourceSize));
+
+    const std::vector<byte> truncated(compressed.begin(), compressed.begin() + 40 + (size_t)sourceSize);
+    const auto              test{LZOStreamCall(lzoStream, _T("t"), truncated.data(), truncated.size())};
+    const auto              testText{std::string(test.begin(), test.end())};
+    const auto              complete{LZOStreamCall(lzoStream, _T("t"), compressed.data(), compressed.size())};
+
+    EXPECT_TRUE(compressed.size() > truncated.size() + 40);
+    EXPECT_TRUE(std::string(complete.begin(), complete.end()).find("Tested 1 file(s), 0 failed") != std::string::npos);
+    EXPECT_TRUE(testText.find("Tested 1 file(s), 1 failed") != std::string::npos);
+}
+
+TEST(Compress, Async)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto appendix{std::to_tstring(GetCurrentProcessId()) + _T("_") + std::to_tstring(GetCurrentThreadId())};
+    const auto inputFile{std::tstring(_T("Input_")) + appendix + _T(".txt")};
+    const auto large{Lorem(3 * 1024 * 1024)};
+
+    EXPECT_TRUE(WriteData(inputFile.data(), large.data(), large.size()));
+
+    for (const auto& options : {_T("--async 1"), _T("--async 4 -b 256k -t 4"), _T("--async 64 -f auto")})
+    {
+        EXPECT_TRUE(large == RoundTrip(lzoStream, inputFile, nullptr, options, _T("--async 2")));
+    }
+
+    const auto bench{LZOStreamCall(lzoStream, (_T("b --io --async 8 -r 1 -e csv -i ") + inputFile).data(), nullptr, 0)};
+    const auto benchText{std::string(bench.begin(), bench.end())};
+
+    DeleteFile(inputFile.data());
+
+    EXPECT_TRUE(benchText.find("blocking,0,") != std::string::npos);
+    EXPECT_TRUE(benchText.find("overlapped,8,") != std::string::npos);
+    EXPECT_TRUE(benchText.find("(error)") == std::string::npos);
+}
+
+TEST(Compress, Direct)
+{
+    const auto lzoStream{_T("LZOStream.exe")};
+    const auto appendix{std::to_tstring(GetCurrentProcessId()) + _T("_") + std::to_tstring(GetCurrentThreadId())};
+    const auto inputFile{std::tstring(_T("Input_")) + appendix + _T(".txt")};
+    const auto large{Lorem(3 * 1024 * 1024)};
+
+    EXPECT_TRUE(WriteData(inputFile.data(), large.data(), large.size()));
+
+    for (const auto& options : {_T("--direct"), _T("--direct --async 4 -b 256k -t 4"), _T("--direct -m")})
+    {
+        // The padding of the last sector is cut off
+        EXPECT_TRUE(large == RoundTrip(lzoStream, inputFile, _T("Lzo1x_1"), options, options));
+    }
+
+    const auto bench{LZOStreamCall(lzoStream, (_T("b --io --direct -r 1 -e csv -i ") + inputFile).data(), nullptr, 0)};
+    const auto benchText{std::string(bench.begin(), bench.end())};
+
+    DeleteFile(inputFile.data());
+
+    EXPECT_TRUE(benchText.find("Io,Depth,MBs,CacheMB") != std::string::npos);
+    EXPECT_TRUE(
+        benchText.find("direct,1,") != std::string::npos || benchText.find("sequential,1,") != std::string::npos);
+    EXPECT_TRUE(benchText.find("(error)") == std::string::npos);
+}
+
+TEST(Compress, Sparse)
+{
+    const auto  lzoStream{_T("LZOStream.exe")};
+    const auto  appendix{std::to_tstring(GetCurrentProcessId()) + _T("_") + std::to_tstring(GetCurrentThreadId())};
+    const auto  inputFile{std::tstring(_T("Input_")) + appendix + _T(".bin")};
+    std::string sparse(loremIpsum);
+
+    sparse.append(16 * 1024 * 1024, '\0');
+    sparse.append(loremIpsum);
+    sparse.append(4 * 1024 * 1024 + 12345, '\0');
+
+    EXPECT_TRUE(WriteData(inputFile.data(), sparse.data(), sparse.size()));
+
+    for (const auto& options : {_T("--sparse"), _T("--sparse --async 4 -t 4"), _T("--sparse --direct")})
+    {
+        uint64_t   allocated{};
+        const auto decompressed{RoundTrip(lzoStream, inputFile, _T("Lzo1x_1"), _T("-b 1m"), options, &allocated)};
+
+        // Holes read as zeros, the zero runs take no space on file systems with sparse files (NTFS)
+        EXPECT_TRUE(sparse == decompressed);
+        EXPECT_TRUE(allocated < sparse.size() / 2);
+    }
+
+    DeleteFile(inputFile.data());
+}
+
+TEST(Compress, Fill)
+{
+    const auto  lzoStream{_T("LZOStream.exe")};
+    std::string filled(1024 * 1024, '\0');
+
+    filled.append(1024 * 1024 + 12345, '\xff');
+
+    for (const auto& options : {_T("c -b 1m"), _T("c -b 256k"), _T("c -b 256k -t 4 -f Lzo1x_1")})
+    {
+        const auto compressed{LZOStreamCall(lzoStream, options, filled.data(), filled.size())};
+        const auto decompressed{LZOStreamCall(lzoStream, _T("d"), compressed.data(), compressed.size())};
+
+        // Each block of a single repeated byte is a header and that byte
+        EXPECT_TRUE(compressed.size() < 1024);
+        EXPECT_TRUE(filled == std::string(decompressed.begin(), decompressed.end()));
+    }
+}
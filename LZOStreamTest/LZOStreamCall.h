@@ -67,18 +67,22 @@ inline std::vector<byte> LZOStreamCall(LPCTSTR lzoStreamExe, LPCTSTR arguments,
     {
         CloseHandle(processInfo.hProcess);
         CloseHandle(processInfo.hThread);
+    }
+
+    CloseHandle(outputWrite);
+    CloseHandle(inputRead);
 
-        if (input && size)
+    // Input is written concurrently, a streaming process produces output before it has read all input
+    std::thread writer([&]() {
+        if (process && input && size)
         {
             DWORD written{};
 
             WriteFile(inputWrite, input, size, &written, nullptr);
         }
-    }
 
-    CloseHandle(inputWrite);
-    CloseHandle(outputWrite);
-    CloseHandle(inputRead);
+        CloseHandle(inputWrite);
+    });
 
     if (process)
     {
@@ -91,13 +95,16 @@ inline std::vector<byte> LZOStreamCall(LPCTSTR lzoStreamExe, LPCTSTR arguments,
         }
     }
 
+    writer.join();
+
     CloseHandle(outputRead);
 
     return output;
 }
 
 inline std::vector<byte> LZOStreamCompress(LPCTSTR lzoStreamExe, const void* input, size_t size,
-    LPCTSTR format = _T("Lzo1x_999"), bool headerless = {}, bool limitless = {})
+    LPCTSTR format = _T("Lzo1x_999"), bool headerless = {}, bool limitless = {}, uint32_t blockSize = {},
+    uint32_t threads = {})
 {
     std::tstring commandLine{_T("c")};
 
@@ -114,12 +121,22 @@ inline std::vector<byte> LZOStreamCompress(LPCTSTR lzoStreamExe, const void* inp
     {
         commandLine += _T(" -l");
     }
+    if (blockSize)
+    {
+        commandLine += _T(" -b ");
+        commandLine += std::to_tstring(blockSize);
+    }
+    if (threads)
+    {
+        commandLine += _T(" -t ");
+        commandLine += std::to_tstring(threads);
+    }
 
     return LZOStreamCall(lzoStreamExe, commandLine.data(), input, size);
 }
 
 inline std::vector<byte> LZOStreamDecompress(LPCTSTR lzoStreamExe, const void* input, size_t size, bool headerless = {},
-    LPCTSTR format = {}, uint32_t blockSize = {})
+    LPCTSTR format = {}, uint32_t blockSize = {}, uint32_t threads = {}, LPCTSTR decoder = {})
 {
     std::tstring commandLine{_T("d")};
 
@@ -137,6 +154,16 @@ inline std::vector<byte> LZOStreamDecompress(LPCTSTR lzoStreamExe, const void* i
         commandLine += _T(" -b ");
         commandLine += std::to_tstring(blockSize);
     }
+    if (threads)
+    {
+        commandLine += _T(" -t ");
+        commandLine += std::to_tstring(threads);
+    }
+    if (decoder)
+    {
+        commandLine += _T(" --decoder ");
+        commandLine += decoder;
+    }
 
     return LZOStreamCall(lzoStreamExe, commandLine.data(), input, size);
 }
@@ -168,7 +195,8 @@ inline bool LZOStreamCall(LPCTSTR lzoStreamExe, LPCTSTR arguments)
     return result;
 }
 
-inline bool LZOStreamCompress(LPCTSTR lzoStreamExe, LPCTSTR input, LPCTSTR output, LPCTSTR format = _T("Lzo1x_999"))
+inline bool LZOStreamCompress(
+    LPCTSTR lzoStreamExe, LPCTSTR input, LPCTSTR output, LPCTSTR format = _T("Lzo1x_999"), LPCTSTR options = {})
 {
     std::tstring commandLine{_T("c")};
 
@@ -183,11 +211,16 @@ inline bool LZOStreamCompress(LPCTSTR lzoStreamExe, LPCTSTR input, LPCTSTR outpu
         commandLine += _T(" -f ");
         commandLine += format;
     }
+    if (options)
+    {
+        commandLine += _T(" ");
+        commandLine += options;
+    }
 
     return LZOStreamCall(lzoStreamExe, commandLine.data());
 }
 
-inline bool LZOStreamDecompress(LPCTSTR lzoStreamExe, LPCTSTR input, LPCTSTR output)
+inline bool LZOStreamDecompress(LPCTSTR lzoStreamExe, LPCTSTR input, LPCTSTR output, LPCTSTR options = {})
 {
     std::tstring commandLine{_T("d")};
 
@@ -197,5 +230,11 @@ inline bool LZOStreamDecompress(LPCTSTR lzoStreamExe, LPCTSTR input, LPCTSTR out
     commandLine += output;
     commandLine += _T("\"");
 
+    if (options)
+    {
+        commandLine += _T(" ");
+        commandLine += options;
+    }
+
     return LZOStreamCall(lzoStreamExe, commandLine.data());
 }
@@ -31,6 +31,8 @@
 #include <atlbase.h>
 #include <string>
 #include <ostream>
+#include <thread>
+#include <random>
 #include "gtest/gtest.h"
 
 namespace std